@@ -83,6 +83,15 @@ static inline uint32_t arch_interrupt_get_status(void)
 	return xthal_get_interrupt();
 }
 
+/* PC interrupted by the interrupt being handled at level */
+#define arch_interrupt_get_pc(level) _arch_interrupt_get_pc(level)
+#define _arch_interrupt_get_pc(level) \
+	({ \
+		uint32_t __pc; \
+		asm volatile("rsr %0, EPC" #level : "=a" (__pc)); \
+		__pc; \
+	})
+
 static inline uint32_t arch_interrupt_global_disable(void)
 {
 	uint32_t flags;
@@ -92,6 +101,22 @@ static inline uint32_t arch_interrupt_global_disable(void)
 	return flags;
 }
 
+/* were IRQs already masked by a global disable when flags were saved ? */
+static inline int arch_interrupt_global_masked(uint32_t flags)
+{
+	/* PS.INTLEVEL */
+	return (flags & 0xf) >= 5;
+}
+
+/* current interrupt level, 0 when not in an IRQ handler or masked section */
+static inline uint32_t arch_interrupt_get_level(void)
+{
+	uint32_t ps;
+
+	asm volatile("rsr %0, ps" : "=a" (ps));
+	return ps & 0xf;
+}
+
 static inline void arch_interrupt_global_enable(uint32_t flags)
 {
 	asm volatile("wsr %0, ps; rsync"
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * Xtensa performance monitor access. Cycles come from CCOUNT, the other
+ * events use the perf monitor counters through ERI when the core has them
+ * and read as 0 when it does not.
+ */
+
+#ifndef __ARCH_PERF_H_
+#define __ARCH_PERF_H_
+
+#include <xtensa/hal.h>
+#include <xtensa/xdm-regs.h>
+#include <stdint.h>
+
+#if XCHAL_NUM_PERF_COUNTERS >= PERF_EVENTS - 1
+
+/* XDM registers in the ERI address space */
+#define ARCH_PERF_ERI(reg)	(0x100000 + (reg))
+
+/* PMCTRL event group select and mask, counting at all interrupt levels */
+#define ARCH_PERF_EVENT(select, mask) \
+	(((mask) << PERF_PMCTRL_MASK_SHIFT) | \
+	((select) << PERF_PMCTRL_SELECT_SHIFT) | PERF_PMCTRL_KRNLCNT)
+
+static inline uint32_t arch_perf_eri_read(uint32_t addr)
+{
+	uint32_t val;
+
+	__asm__ __volatile__ ("rer %0, %1" : "=a" (val) : "a" (addr));
+	return val;
+}
+
+static inline void arch_perf_eri_write(uint32_t addr, uint32_t val)
+{
+	__asm__ __volatile__ ("wer %0, %1; isync" : : "a" (val), "a" (addr)
+		: "memory");
+}
+
+/* counter n - 1 counts event n, CCOUNT counts cycles */
+static inline void arch_perf_set_event(int event, uint32_t select,
+	uint32_t mask)
+{
+	arch_perf_eri_write(ARCH_PERF_ERI(XDM_PERF_PMCTRL(event - 1)),
+		ARCH_PERF_EVENT(select, mask));
+}
+
+/* event selects as used by the Linux xtensa PMU driver */
+static inline void arch_perf_init(void)
+{
+	arch_perf_eri_write(ARCH_PERF_ERI(XDM_PERF_PMG), 0);
+
+	/* committed instructions */
+	arch_perf_set_event(PERF_INSTR, 2, 0xffff);
+	/* instruction cache misses */
+	arch_perf_set_event(PERF_ICACHE_MISS, 4, 0x2);
+	/* data cache load misses */
+	arch_perf_set_event(PERF_DCACHE_MISS, 12, 0x1);
+
+	arch_perf_eri_write(ARCH_PERF_ERI(XDM_PERF_PMG), PERF_PMG_ENABLE);
+}
+
+static inline uint32_t arch_perf_events(void)
+{
+	return (1 << PERF_EVENTS) - 1;
+}
+
+static inline void arch_perf_read(uint32_t *count)
+{
+	int i;
+
+	count[PERF_CYCLES] = xthal_get_ccount();
+	for (i = 1; i < PERF_EVENTS; i++)
+		count[i] = arch_perf_eri_read(ARCH_PERF_ERI(XDM_PERF_PM0 +
+			((i - 1) << 2)));
+}
+
+#else
+
+static inline void arch_perf_init(void) {}
+
+static inline uint32_t arch_perf_events(void)
+{
+	return 1 << PERF_CYCLES;
+}
+
+static inline void arch_perf_read(uint32_t *count)
+{
+	int i;
+
+	count[PERF_CYCLES] = xthal_get_ccount();
+	for (i = 1; i < PERF_EVENTS; i++)
+		count[i] = 0;
+}
+
+#endif
+
+#endif
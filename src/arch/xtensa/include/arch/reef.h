@@ -40,4 +40,12 @@ void *xthal_memcpy(void *dst, const void *src, size_t len);
 #define arch_memcpy(dest, src, size) \
 	xthal_memcpy(dest, src, size)
 
+static inline uint32_t arch_get_stack_ptr(void)
+{
+	uint32_t sp;
+
+	__asm__ __volatile__ ("mov %0, a1" : "=a" (sp) : : "memory");
+	return sp;
+}
+
 #endif
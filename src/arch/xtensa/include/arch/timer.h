@@ -49,6 +49,7 @@ struct timer {
 int timer64_register(struct timer *timer, void(*handler)(void *arg), void *arg);
 void timer_64_handler(void *arg);
 
+/* IRQ off section isn't in the watermark, it's only run at boot */
 static inline int arch_timer_register(struct timer *timer,
 	void(*handler)(void *arg), void *arg)
 {
@@ -82,6 +83,15 @@ uint64_t arch_timer_get_system(struct timer *timer);
 
 int arch_timer_set(struct timer *timer, uint64_t ticks);
 
+/* 32 bit CPU cycle count and compare, for timers with a directly registered
+ * IRQ handler and no 64 bit rollover tracking */
+static inline uint32_t arch_timer_get_cycles(void)
+{
+	return xthal_get_ccount();
+}
+
+int arch_timer_set_compare(struct timer *timer, uint32_t cycles);
+
 static inline void arch_timer_clear(struct timer *timer)
 {
 	arch_interrupt_clear(timer->irq);
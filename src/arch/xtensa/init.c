@@ -37,6 +37,7 @@
 #include <arch/task.h>
 #include <reef/debug.h>
 #include <reef/init.h>
+#include <reef/perf.h>
 #include <stdint.h>
 
 /* TODO: this should be fixed by rotating the register Window on the stack and
@@ -154,6 +155,7 @@ int arch_init(struct reef *reef)
 {
 	register_exceptions();
 	arch_init_tasks();
+	perf_init();
 	return 0;
 }
 
@@ -31,110 +31,97 @@
 
 #include <reef/schedule.h>
 #include <reef/interrupt.h>
+#include <reef/load.h>
 #include <platform/platform.h>
 #include <reef/debug.h>
 #include <stdint.h>
 #include <errno.h>
 
-static struct task *_irq_low_task = NULL;
-static struct task *_irq_med_task = NULL;
-static struct task *_irq_high_task = NULL;
-
-static inline uint32_t task_get_irq(struct task *task)
-{
+/* tasks set to run at one task IRQ level */
+struct irq_task {
+	spinlock_t lock;
+	struct list_item list;	/* tasks in the order they were set */
 	uint32_t irq;
+};
 
-	switch (task->priority) {
-	case TASK_PRI_MED + 1 ... TASK_PRI_LOW:
-		irq = PLATFORM_IRQ_TASK_LOW;
-		break;
-	case TASK_PRI_HIGH ... TASK_PRI_MED - 1:
-		irq = PLATFORM_IRQ_TASK_HIGH;
-		break;
-	case TASK_PRI_MED:
-	default:
-		irq = PLATFORM_IRQ_TASK_MED;
-		break;
-	}
-
-	return irq;
-}
+static struct irq_task irq_task_low;
+static struct irq_task irq_task_med;
+static struct irq_task irq_task_high;
 
-static inline void task_set_data(struct task *task)
+static inline struct irq_task *task_get_irq_task(struct task *task)
 {
 	switch (task->priority) {
 	case TASK_PRI_MED + 1 ... TASK_PRI_LOW:
-		_irq_low_task = task;
-		break;
+		return &irq_task_low;
 	case TASK_PRI_HIGH ... TASK_PRI_MED - 1:
-		_irq_high_task = task;
-		break;
+		return &irq_task_high;
 	case TASK_PRI_MED:
 	default:
-		_irq_med_task = task;
-		break;
+		return &irq_task_med;
 	}
 }
 
-static void _irq_low(void *arg)
+/*
+ * Run every task set at this level. The IRQ is only cleared with the list
+ * empty, a task set after that raises it again so none is lost.
+ */
+static void _irq_task(void *arg)
 {
-	struct task *task = *(struct task **)arg;
-	uint32_t irq;
+	struct irq_task *irq_task = arg;
+	struct load_frame frame;
+	struct task *task;
+	uint32_t flags;
 
-	if (task->func)
-		task->func(task->data);
+	spin_lock_irq(&irq_task->lock, flags);
 
-	schedule_task_complete(task);
-	irq = task_get_irq(task);
-	interrupt_clear(irq);
-}
+	while (!list_is_empty(&irq_task->list)) {
+		task = list_first_item(&irq_task->list, struct task, irq_list);
+		list_item_del(&task->irq_list);
+		spin_unlock_irq(&irq_task->lock, flags);
 
-static void _irq_med(void *arg)
-{
-	struct task *task = *(struct task **)arg;
-	uint32_t irq;
+		load_frame_begin(&frame);
 
-	if (task->func)
-		task->func(task->data);
+		if (task->func)
+			task->func(task->data);
 
-	schedule_task_complete(task);
-	irq = task_get_irq(task);
-	interrupt_clear(irq);
-}
+		load_frame_end(&frame, NULL);
 
-static void _irq_high(void *arg)
-{
-	struct task *task = *(struct task **)arg;
-	uint32_t irq;
+		schedule_task_complete(task);
 
-	if (task->func)
-		task->func(task->data);
+		spin_lock_irq(&irq_task->lock, flags);
+	}
 
-	schedule_task_complete(task);
-	irq = task_get_irq(task);
-	interrupt_clear(irq);
+	interrupt_clear(irq_task->irq);
+	spin_unlock_irq(&irq_task->lock, flags);
 }
 
 /* architecture specific method of running task */
 void arch_run_task(struct task *task)
 {
-	uint32_t irq;
+	struct irq_task *irq_task = task_get_irq_task(task);
+	uint32_t flags;
 
-	task_set_data(task);
-	irq = task_get_irq(task);
-	interrupt_set(irq);
+	spin_lock_irq(&irq_task->lock, flags);
+	list_item_append(&task->irq_list, &irq_task->list);
+	interrupt_set(irq_task->irq);
+	spin_unlock_irq(&irq_task->lock, flags);
 }
 
-int arch_init_tasks(void)
+static void irq_task_init(struct irq_task *irq_task, uint32_t irq)
 {
-	interrupt_register(PLATFORM_IRQ_TASK_LOW, _irq_low, &_irq_low_task);
-	interrupt_enable(PLATFORM_IRQ_TASK_LOW);
+	spinlock_init(&irq_task->lock);
+	list_init(&irq_task->list);
+	irq_task->irq = irq;
 
-	interrupt_register(PLATFORM_IRQ_TASK_MED, _irq_med, &_irq_med_task);
-	interrupt_enable(PLATFORM_IRQ_TASK_MED);
+	interrupt_register(irq, _irq_task, irq_task);
+	interrupt_enable(irq);
+}
 
-	interrupt_register(PLATFORM_IRQ_TASK_HIGH, _irq_high, &_irq_high_task);
-	interrupt_enable(PLATFORM_IRQ_TASK_HIGH);
+int arch_init_tasks(void)
+{
+	irq_task_init(&irq_task_low, PLATFORM_IRQ_TASK_LOW);
+	irq_task_init(&irq_task_med, PLATFORM_IRQ_TASK_MED);
+	irq_task_init(&irq_task_high, PLATFORM_IRQ_TASK_HIGH);
 
 	return 0;
 }
@@ -148,7 +148,7 @@ uint64_t arch_timer_get_system(struct timer *timer)
 		return 0;
 	}
 
-	flags = arch_interrupt_global_disable();
+	flags = interrupt_global_disable();
 
 	/* read low 32 bits */
 	low = xthal_get_ccount();
@@ -164,7 +164,7 @@ uint64_t arch_timer_get_system(struct timer *timer)
 
 	time = ((uint64_t)high << 32) | low;
 
-	arch_interrupt_global_enable(flags);
+	interrupt_global_enable(flags);
 
 	return time;
 }
@@ -177,7 +177,7 @@ int arch_timer_set(struct timer *timer, uint64_t ticks)
 	if ((ticks & 0xffffffff) == 0x1)
 		ticks++;
 
-	flags = arch_interrupt_global_disable();
+	flags = interrupt_global_disable();
 
 	/* same hi 64 bit context as ticks ? */
 	if (hitimeout == timer->hitime) {
@@ -187,7 +187,7 @@ int arch_timer_set(struct timer *timer, uint64_t ticks)
 		timer->hitimeout = 0;
 	} else if (hitimeout < timer->hitime) {
 		/* cant be in the past */
-		arch_interrupt_global_enable(flags);
+		interrupt_global_enable(flags);
 		return -EINVAL;
 	} else {
 		/* set for checking at next timeout */
@@ -205,10 +205,31 @@ int arch_timer_set(struct timer *timer, uint64_t ticks)
 	case TIMER2:
 		xthal_set_ccompare(2, time);
 		break;
+	default:
+		interrupt_global_enable(flags);
+		return -EINVAL;
+	}
+
+	interrupt_global_enable(flags);
+	return 0;
+}
+
+/* set comparator, also clears a pending compare IRQ */
+int arch_timer_set_compare(struct timer *timer, uint32_t cycles)
+{
+	switch (timer->id) {
+	case TIMER0:
+		xthal_set_ccompare(0, cycles);
+		break;
+	case TIMER1:
+		xthal_set_ccompare(1, cycles);
+		break;
+	case TIMER2:
+		xthal_set_ccompare(2, cycles);
+		break;
 	default:
 		return -EINVAL;
 	}
 
-	arch_interrupt_global_enable(flags);
 	return 0;
 }
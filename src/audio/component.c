@@ -96,6 +96,7 @@ struct comp_dev *comp_new(struct sof_ipc_comp *comp)
 	spinlock_init(&cdev->lock);
 	list_init(&cdev->bsource_list);
 	list_init(&cdev->bsink_list);
+	PERF_REGION_INIT(&cdev->perf, TRACE_MARK_COMP(cdev));
 
 	return cdev;
 }
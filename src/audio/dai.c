@@ -42,7 +42,11 @@
 #include <reef/stream.h>
 #include <reef/audio/component.h>
 #include <reef/audio/pipeline.h>
+#include <reef/clock.h>
 #include <platform/dma.h>
+#include <platform/clk.h>
+#include <platform/platform.h>
+#include <platform/timer.h>
 #include <arch/cache.h>
 
 #define DAI_PLAYBACK_STREAM	0
@@ -68,6 +72,8 @@ struct dai_data {
 
 	volatile uint64_t *dai_pos; /* host can read back this value without IPC */
 	uint64_t wallclock;	/* wall clock at stream start */
+	uint32_t period_ticks;	/* platform timer ticks per period */
+	uint32_t dma_errors;	/* periods lost to DMA errors */
 };
 
 static int dai_cmd(struct comp_dev *dev, int cmd, void *data);
@@ -78,10 +84,46 @@ static void dai_dma_cb(void *data, uint32_t type, struct dma_sg_elem *next)
 	struct comp_dev *dev = (struct comp_dev *)data;
 	struct dai_data *dd = comp_get_drvdata(dev);
 	struct comp_buffer *dma_buffer;
+	struct pipeline_dma_tstamp tstamp;
 	uint32_t copied_size;
 
+	/* latch DMA completion time before anything else */
+	tstamp.time = platform_timer_get(platform_timer);
+
+	trace_mark(TRACE_MARK_DAI_DMA, TRACE_MARK_COMP(dev));
 	tracev_dai("irq");
 
+	/* DMA error, the period was lost and the channel restarts from the
+	 * next period. Positions are kept in step with the DMA, only a failed
+	 * restart stops the DAI and is reported as an XRUN.
+	 */
+	if (type == DMA_IRQ_TYPE_ERROR) {
+		dd->dma_errors++;
+		trace_dai_error("eDE");
+		trace_value(dd->dma_errors);
+
+		if (next->size == DMA_RELOAD_END) {
+			dai_trigger(dd->dai, COMP_CMD_STOP,
+				dev->params.direction);
+			if (dev->params.direction == SOF_IPC_STREAM_PLAYBACK)
+				pipeline_xrun(dev->pipeline, dev,
+					-(int32_t)dd->period_bytes);
+			else
+				pipeline_xrun(dev->pipeline, dev,
+					dd->period_bytes);
+			return;
+		}
+
+		/* lost capture period holds stale samples, send silence */
+		if (dev->params.direction == SOF_IPC_STREAM_CAPTURE) {
+			dma_buffer = list_first_item(&dev->bsink_list,
+				struct comp_buffer, source_list);
+			bzero(dma_buffer->w_ptr, dd->period_bytes);
+			dcache_writeback_region(dma_buffer->w_ptr,
+				dd->period_bytes);
+		}
+	}
+
 	/* is stream stopped or paused ? */
 	if (dev->state != COMP_STATE_ACTIVE) {
 
@@ -132,6 +174,13 @@ static void dai_dma_cb(void *data, uint32_t type, struct dma_sg_elem *next)
 		}
 	}
 
+	/* record position at completion for timestamp interpolation */
+	tstamp.dai_posn = dev->position;
+	tstamp.wallclock = dd->wallclock;
+	tstamp.period_bytes = dd->period_bytes;
+	tstamp.period_ticks = dd->period_ticks;
+	pipeline_set_dma_tstamp(dev->pipeline, &tstamp);
+
 	/* notify pipeline that DAI needs it's buffer processed */
 	pipeline_schedule_copy(dev->pipeline, 0);
 
@@ -181,14 +230,15 @@ static struct comp_dev *dai_new(struct sof_ipc_comp *comp)
 	dd->last_bytes = 0;
 
 	/* get DMA channel from DMAC1 */
-	dd->chan = dma_channel_get(dd->dma);
+	dd->chan = dma_channel_get(dd->dma, DMA_PRIO_HIGH);
 	if (dd->chan < 0){
 		trace_dai_error("eDc");
 		goto error;
 	}
 
 	/* set up callback */
-	dma_set_cb(dd->dma, dd->chan, DMA_IRQ_TYPE_LLIST, dai_dma_cb, dev);
+	dma_set_cb(dd->dma, dd->chan, DMA_IRQ_TYPE_LLIST |
+		DMA_IRQ_TYPE_ERROR, dai_dma_cb, dev);
 	dev->state = COMP_STATE_READY;
 	return dev;
 
@@ -369,6 +419,11 @@ static int dai_params(struct comp_dev *dev)
 		return -EINVAL;
 	}
 
+	/* period duration used to interpolate position between DMA IRQs */
+	if (dev->params.rate)
+		dd->period_ticks = (uint64_t)dev->frames *
+			clock_get_freq(PLATFORM_SCHED_CLOCK) / dev->params.rate;
+
 	if (dev->params.direction == SOF_IPC_STREAM_PLAYBACK) {
 		dma_buffer = list_first_item(&dev->bsource_list,
 			struct comp_buffer, sink_list);
@@ -408,9 +463,11 @@ static int dai_prepare(struct comp_dev *dev)
 	}
 
 	ret = dma_set_config(dd->dma, dd->chan, &dd->config);
-	if (ret == 0)
-		dev->state = COMP_STATE_PREPARE;
-	return ret;
+	if (ret < 0)
+		return ret;
+
+	dev->state = COMP_STATE_PREPARE;
+	return 0;
 }
 
 static int dai_reset(struct comp_dev *dev)
@@ -422,6 +479,9 @@ static int dai_reset(struct comp_dev *dev)
 
 	trace_dai("res");
 
+	if (dev->pipeline)
+		pipeline_clear_dma_tstamp(dev->pipeline);
+
 	list_for_item_safe(elist, tlist, &config->elem_list) {
 		elem = container_of(elist, struct dma_sg_elem, list);
 		list_item_del(&elem->list);
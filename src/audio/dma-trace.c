@@ -39,12 +39,17 @@
 #include <reef/lock.h>
 #include <stdint.h>
 
+/*
+ * The local trace buffer is split into two halves. dtrace_event() writers
+ * fill one half while the other half is copied to the host by a non blocking
+ * DMA started from the trace work. Writers never wait for the DMA, data is
+ * dropped and counted when both halves are full.
+ */
+
 static struct dma_trace_data *trace_data = NULL;
 
 static int dma_trace_new_buffer(struct dma_trace_data *d, uint32_t buffer_size)
 {
-	struct dma_trace_buf *buffer = &d->dmatb;
-
 	trace_buffer("nlb");
 
 	/* validate request */
@@ -54,54 +59,115 @@ static int dma_trace_new_buffer(struct dma_trace_data *d, uint32_t buffer_size)
 		return -ENOMEM;
 	}
 
-	/* allocate new buffer */
-	buffer->addr = rballoc(RZONE_RUNTIME, RFLAGS_NONE, buffer_size);
-	if (buffer->addr == NULL) {
-		trace_buffer_error("ebm");
-		return -ENOMEM;
+	/* allocate new buffer, halves are only sent up to their used bytes */
+	if (d->addr == NULL) {
+		d->addr = rballoc(RZONE_RUNTIME, RFLAGS_NONE, buffer_size);
+		if (d->addr == NULL) {
+			trace_buffer_error("ebm");
+			return -ENOMEM;
+		}
 	}
 
-	bzero(buffer->addr, buffer_size);
-
-	buffer->size = buffer_size;
-	buffer->w_ptr = buffer->r_ptr = buffer->addr;
-	buffer->end_addr = buffer->addr + buffer->size;
+	d->half_size = buffer_size >> 1;
+	d->half[0].addr = d->addr;
+	d->half[1].addr = d->addr + d->half_size;
+	d->half[0].used = d->half[0].sent = 0;
+	d->half[1].used = d->half[1].sent = 0;
+	d->fill = 0;
 
 	return 0;
 }
 
+/* start DMA of the next chunk of the sent half, lock held by caller */
 static void trace_send(struct dma_trace_data *d)
 {
-	struct dma_trace_buf *buffer = &d->dmatb;
-	struct dma_sg_config *config = &d->config;
-	uint32_t size = 0;
-	int32_t offset = 0;
+	struct dma_trace_buf *half;
+	uint32_t size;
+	int32_t ret;
 
-	if (buffer->w_ptr == buffer->r_ptr)
+	/* DMA in flight or no host buffer yet */
+	if (d->copy_size || d->dma == NULL)
 		return;
 
-	size = buffer->w_ptr - buffer->r_ptr;
+	half = &d->half[d->fill ^ 1];
+
+	/* flush a partly filled half if the other half is done */
+	if (half->sent == half->used) {
+		half->used = half->sent = 0;
+		if (d->half[d->fill].used == 0)
+			return;
+		d->fill ^= 1;
+		half = &d->half[d->fill ^ 1];
+	}
+
+	size = half->used - half->sent;
 	if (d->host_offset + size > d->host_size)
 		d->host_offset = 0;
 
-	offset = dma_copy_to_host(config, d->host_offset,
-		buffer->r_ptr, size);
-	if (offset < 0) {
+	dcache_writeback_region(half->addr + half->sent, size);
+
+	ret = dma_copy_to_host_nowait(d->dma, d->chan, &d->config,
+		d->host_offset, half->addr + half->sent, size);
+	if (ret < 0) {
 		trace_buffer_error("ebb");
 		return;
 	}
 
-	d->host_offset += size;
-	buffer->r_ptr += size;
+	d->copy_size = ret;
+}
+
+/* DMA copy complete - any next chunk is started from work context */
+static void trace_dma_cb(void *data, uint32_t type, struct dma_sg_elem *next)
+{
+	struct dma_trace_data *d = (struct dma_trace_data *)data;
+	struct dma_trace_buf *half;
+	uint32_t flags;
 
-	trace_buffer("dts");
+	spin_lock_irq(&d->lock, flags);
+
+	half = &d->half[d->fill ^ 1];
+
+	/* copy failed - rest of the half is lost and counted as overflow */
+	if (type == DMA_IRQ_TYPE_ERROR) {
+		d->overflow += half->used - half->sent;
+		half->used = half->sent = 0;
+		d->copy_size = 0;
+		spin_unlock_irq(&d->lock, flags);
+		next->size = DMA_RELOAD_END;
+		return;
+	}
+
+	half->sent += d->copy_size;
+	d->host_offset += d->copy_size;
+	d->copy_size = 0;
+
+	/* free the half for writers when it's all sent */
+	if (half->sent == half->used)
+		half->used = half->sent = 0;
+	else
+		work_reschedule_default(&d->dmat_work,
+			DMA_TRACE_RESCHEDULE_US);
+
+	spin_unlock_irq(&d->lock, flags);
+
+	next->size = DMA_RELOAD_END;
 }
 
 static uint32_t trace_work(void *data, uint32_t delay)
 {
 	struct dma_trace_data *d = (struct dma_trace_data *)data;
+	uint32_t flags, overflow;
 
+	spin_lock_irq(&d->lock, flags);
 	trace_send(d);
+	overflow = d->overflow;
+	spin_unlock_irq(&d->lock, flags);
+
+	if (overflow != d->overflow_reported) {
+		trace_buffer_error("ebo");
+		trace_value(overflow);
+		d->overflow_reported = overflow;
+	}
 
 	/* reschedule the trace copying work */
 	return DMA_TRACE_US;
@@ -115,6 +181,7 @@ int dma_trace_init(struct dma_trace_data *d)
 
 	/* init buffer elems */
 	list_init(&d->config.elem_list);
+	spinlock_init(&d->lock);
 
 	/* allocate local DMA buffer */
 	err = dma_trace_new_buffer(d, DMA_TRACE_LOCAL_SIZE);
@@ -124,71 +191,129 @@ int dma_trace_init(struct dma_trace_data *d)
 	}
 
 	d->host_offset = 0;
+	d->copy_size = 0;
 	trace_data = d;
 
 	work_init(&d->dmat_work, trace_work, d, WORK_ASYNC);
 	return 0;
 }
 
-int dma_trace_host_buffer(struct dma_trace_data *d, struct dma_sg_elem *elem,
-		uint32_t host_size)
+int dma_trace_host_buffer(struct dma_trace_data *d, struct dma_sg_elem *elems,
+		uint32_t count, uint32_t host_size)
 {
-	struct dma_sg_elem *e;
+	struct dma_sg_elem *old;
+	uint32_t flags, i;
 
-	/* allocate new host DMA elem and add it to our list */
-	e = rzalloc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*e));
-	if (e == NULL)
-		return -ENOMEM;
+	spin_lock_irq(&d->lock, flags);
+
+	/* can't swap the SG list under a DMA copy, host must retry */
+	if (d->copy_size) {
+		spin_unlock_irq(&d->lock, flags);
+		trace_buffer_error("ebB");
+		return -EBUSY;
+	}
+
+	/* drop any previous host buffer */
+	list_init(&d->config.elem_list);
+	old = d->host_elems;
+
+	/* elems are one allocation, link them for the SG list walkers */
+	d->host_elems = elems;
+	for (i = 0; i < count; i++)
+		list_item_append(&elems[i].list, &d->config.elem_list);
 
-	*e = *elem;
 	d->host_size = host_size;
+	d->host_offset = 0;
 
-	list_item_append(&e->list, &d->config.elem_list);
+	spin_unlock_irq(&d->lock, flags);
+
+	if (old)
+		rbfree(old);
 	return 0;
 }
 
 void dma_trace_config_ready(struct dma_trace_data *d)
 {
+	struct dma *dma;
+	int chan;
+
+	/* reserve a channel for trace so sends never wait for one */
+	if (d->dma == NULL) {
+		dma = dma_get(DMA_ID_DMAC0);
+		if (dma == NULL)
+			return;
+
+		chan = dma_channel_get(dma, DMA_PRIO_LOW);
+		if (chan < 0) {
+			trace_buffer_error("ebc");
+			return;
+		}
+
+		dma_set_cb(dma, chan, DMA_IRQ_TYPE_LLIST | DMA_IRQ_TYPE_ERROR,
+			trace_dma_cb, d);
+		d->chan = chan;
+		d->dma = dma;
+	}
+
 	work_schedule_default(&d->dmat_work, DMA_TRACE_US);
 }
 
-void dtrace_event(char *e)
+/* copy data into the filling half */
+static void dtrace_add(struct dma_trace_data *d, void *data, uint32_t length)
 {
-	struct dma_trace_buf *buffer = NULL;
-	int length = rstrlen(e);
-	int margin = 0;
+	struct dma_trace_buf *half;
+	int kick = 0;
+	uint32_t flags;
 
-	if (trace_data == NULL || length < 1) {
-		trace_buffer_error("ele");
-		return;
+	spin_lock_irq(&d->lock, flags);
+
+	half = &d->half[d->fill];
+
+	/* half full - switch to the other half if it has been sent */
+	if (half->used + length > d->half_size) {
+		if (d->half[d->fill ^ 1].used || length > d->half_size) {
+			d->overflow += length;
+			spin_unlock_irq(&d->lock, flags);
+			return;
+		}
+
+		d->fill ^= 1;
+		half = &d->half[d->fill];
+		kick = 1;
 	}
 
-	buffer = &trace_data->dmatb;
-	if (buffer == NULL) {
+	memcpy(half->addr + half->used, data, length);
+	half->used += length;
+
+	spin_unlock_irq(&d->lock, flags);
+
+	/* send the full half soon, from work context */
+	if (kick)
+		work_reschedule_default(&d->dmat_work, DMA_TRACE_RESCHEDULE_US);
+}
+
+void dtrace_event(char *e)
+{
+	struct dma_trace_data *d = trace_data;
+	int length = rstrlen(e);
+
+	if (d == NULL || length < 1) {
 		trace_buffer_error("ele");
 		return;
 	}
 
-	margin = buffer->end_addr - buffer->w_ptr;
-
-	if (margin > length) {
-		memcpy(buffer->w_ptr, e, length);
-		buffer->w_ptr += length;
-	} else {
-		memcpy(buffer->w_ptr, e, margin);
-		buffer->w_ptr += margin;
-
-		trace_send(trace_data);
-		buffer->w_ptr = buffer->r_ptr = buffer->addr;
-		bzero(buffer->addr, buffer->size);
+	dtrace_add(d, e, length);
+}
 
-		memcpy(buffer->w_ptr, e + margin, length - margin);
-		buffer->w_ptr += length -margin;
+/* binary records, the host finds them by their own header */
+void dtrace_data(void *data, uint32_t size)
+{
+	struct dma_trace_data *d = trace_data;
 
-		trace_buffer("ebs");
+	if (d == NULL || size == 0) {
+		trace_buffer_error("eld");
+		return;
 	}
 
-	length = buffer->w_ptr - buffer->r_ptr;
-	if (length >= (DMA_TRACE_LOCAL_SIZE / 2))
-		trace_send(trace_data);
+	dtrace_add(d, data, size);
 }
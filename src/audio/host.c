@@ -69,6 +69,7 @@ struct host_data {
 	/* local and host DMA buffer info */
 	struct hc_buf host;
 	struct hc_buf local;
+	struct dma_sg_elem *host_elems;	/* host SG elems from page table */
 	uint32_t host_size;
 	/* host possition reporting related */
 	volatile uint32_t *host_pos;    /* read/write pos, update to mailbox for host side */
@@ -81,6 +82,7 @@ struct host_data {
 	uint32_t next_inc;
 	uint32_t period_bytes;
 	uint32_t period_count;
+	uint32_t dma_errors;		/* period copies lost to DMA errors */
 
 	/* stream info */
 	struct sof_ipc_stream_posn posn; /* TODO: update this */
@@ -120,8 +122,32 @@ static void host_dma_cb(void *data, uint32_t type, struct dma_sg_elem *next)
 	local_elem = list_first_item(&hd->config.elem_list,
 		struct dma_sg_elem, list);
 
+	trace_mark(TRACE_MARK_HOST_DMA, TRACE_MARK_COMP(dev));
 	tracev_host("irq");
 
+	/* DMA error, the period copy was lost. Positions are left as they are
+	 * so the next host_copy() restarts it at the next period boundary,
+	 * only a failed restart is reported as an XRUN.
+	 */
+	if (type == DMA_IRQ_TYPE_ERROR) {
+		hd->dma_errors++;
+		trace_host_error("eDE");
+		trace_value(hd->dma_errors);
+
+		if (next->size == DMA_RELOAD_END) {
+			if (dev->params.direction == SOF_IPC_STREAM_PLAYBACK)
+				pipeline_xrun(dev->pipeline, dev,
+					-(int32_t)local_elem->size);
+			else
+				pipeline_xrun(dev->pipeline, dev,
+					local_elem->size);
+		}
+
+		next->size = DMA_RELOAD_END;
+		wait_failed(&hd->complete);
+		return;
+	}
+
 	/* update buffer positions */
 	dma_buffer = hd->dma_buffer;
 
@@ -267,14 +293,15 @@ static struct comp_dev *host_new(struct sof_ipc_comp *comp)
 	list_item_prepend(&elem->list, &hd->config.elem_list);
 
 	/* get DMA channel from DMAC */
-	hd->chan = dma_channel_get(hd->dma);
+	hd->chan = dma_channel_get(hd->dma, DMA_PRIO_NORMAL);
 	if (hd->chan < 0) {
 		trace_host_error("eDC");
 		goto error;
 	}
 
 	/* set up callback */
-	dma_set_cb(hd->dma, hd->chan, DMA_IRQ_TYPE_LLIST, host_dma_cb, dev);
+	dma_set_cb(hd->dma, hd->chan, DMA_IRQ_TYPE_LLIST |
+		DMA_IRQ_TYPE_ERROR, host_dma_cb, dev);
 
 	/* init posn data. TODO: other fields */
 	hd->posn.comp_id = comp->id;
@@ -288,6 +315,15 @@ error:
 	return NULL;
 }
 
+static void host_elems_free(struct host_data *hd)
+{
+	list_init(&hd->host.elem_list);
+	if (hd->host_elems) {
+		rbfree(hd->host_elems);
+		hd->host_elems = NULL;
+	}
+}
+
 static void host_free(struct comp_dev *dev)
 {
 	struct host_data *hd = comp_get_drvdata(dev);
@@ -299,6 +335,7 @@ static void host_free(struct comp_dev *dev)
 		struct dma_sg_elem, list);
 	dma_channel_put(hd->dma, hd->chan);
 
+	host_elems_free(hd);
 	rfree(elem);
 	rfree(hd);
 	rfree(dev);
@@ -565,21 +602,21 @@ static int host_cmd(struct comp_dev *dev, int cmd, void *data)
 	return ret;
 }
 
-static int host_buffer(struct comp_dev *dev, struct dma_sg_elem *elem,
-		uint32_t host_size)
+static int host_buffer(struct comp_dev *dev, struct dma_sg_elem *elems,
+		uint32_t count, uint32_t host_size)
 {
 	struct host_data *hd = comp_get_drvdata(dev);
-	struct dma_sg_elem *e;
+	uint32_t i;
 
-	/* allocate new host DMA elem and add it to our list */
-	e = rzalloc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*e));
-	if (e == NULL)
-		return -ENOMEM;
+	/* replace any previous host buffer */
+	host_elems_free(hd);
 
-	*e = *elem;
-	hd->host_size = host_size;
+	/* elems are one allocation, link them for the SG list walkers */
+	hd->host_elems = elems;
+	for (i = 0; i < count; i++)
+		list_item_append(&elems[i].list, &hd->host.elem_list);
 
-	list_item_append(&e->list, &hd->host.elem_list);
+	hd->host_size = host_size;
 	return 0;
 }
 
@@ -592,12 +629,7 @@ static int host_reset(struct comp_dev *dev)
 	trace_host("res");
 
 	/* free all host DMA elements */
-	list_for_item_safe(elist, tlist, &hd->host.elem_list) {
-
-		e = container_of(elist, struct dma_sg_elem, list);
-		list_item_del(&e->list);
-		rfree(e);
-	}
+	host_elems_free(hd);
 
 	/* free all local DMA elements */
 	list_for_item_safe(elist, tlist, &hd->local.elem_list) {
@@ -39,13 +39,20 @@
 #include <reef/alloc.h>
 #include <reef/debug.h>
 #include <reef/ipc.h>
+#include <reef/clock.h>
 #include <platform/timer.h>
+#include <platform/clk.h>
 #include <platform/platform.h>
 #include <reef/audio/component.h>
 #include <reef/audio/pipeline.h>
 
+/* buffer fill level window */
+#define PIPELINE_FILL_WINDOW_US	100000
+
 struct pipeline_data {
 	spinlock_t lock;
+	struct sof_ipc_trace_xrun_reply xrun;	/* post-mortem record */
+	uint32_t xrun_filling;			/* record being taken */
 };
 
 /* generic operation data used by op graph walk */
@@ -229,12 +236,17 @@ struct pipeline *pipeline_new(struct sof_ipc_pipe_new *pipe_desc,
 	/* init pipeline */
 	p->sched_comp = cd;
 	schedule_task_init(&p->pipe_task, pipeline_task, p);
+	p->pipe_task.id = pipe_desc->pipeline_id;
 	schedule_task_config(&p->pipe_task, pipe_desc->priority,
 		pipe_desc->core);
 	list_init(&p->comp_list);
 	list_init(&p->buffer_list);
 	spinlock_init(&p->lock);
+	spinlock_init(&p->tstamp_lock);
 	memcpy(&p->ipc_pipe, pipe_desc, sizeof(*pipe_desc));
+	load_window_register(&p->load, pipe_desc->pipeline_id);
+	p->fill_ticks = clock_us_to_ticks(PLATFORM_SCHED_CLOCK,
+		PIPELINE_FILL_WINDOW_US);
 
 	return p;
 }
@@ -252,6 +264,7 @@ int pipeline_free(struct pipeline *p)
 
 	/* remove from any scheduling */
 	schedule_task_free(&p->pipe_task);
+	load_window_unregister(&p->load);
 
 	/* disconnect components */
 	disconnect_downstream(p, p->sched_comp, p->sched_comp);
@@ -860,6 +873,63 @@ upstream:
 	return res;
 }
 
+/* latch DAI DMA period completion - called from DAI DMA IRQ */
+void pipeline_set_dma_tstamp(struct pipeline *p,
+	struct pipeline_dma_tstamp *tstamp)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&p->tstamp_lock, flags);
+	p->tstamp = *tstamp;
+	p->tstamp.valid = 1;
+	spin_unlock_irq(&p->tstamp_lock, flags);
+}
+
+void pipeline_clear_dma_tstamp(struct pipeline *p)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&p->tstamp_lock, flags);
+	p->tstamp.valid = 0;
+	spin_unlock_irq(&p->tstamp_lock, flags);
+}
+
+/*
+ * Interpolate DAI position from last DMA completion record. The position
+ * moves linearly through the period so is good to a sample and does not
+ * need a graph walk. Returns 0 if no record is available.
+ */
+static int timestamp_interpolate(struct pipeline *p,
+	struct sof_ipc_stream_posn *posn)
+{
+	struct pipeline_dma_tstamp ts;
+	uint64_t now, elapsed;
+	uint32_t flags;
+
+	spin_lock_irq(&p->tstamp_lock, flags);
+	ts = p->tstamp;
+	spin_unlock_irq(&p->tstamp_lock, flags);
+
+	if (!ts.valid || ts.period_ticks == 0)
+		return 0;
+
+	now = platform_timer_get(platform_timer);
+
+	/* DMA can't be more than a period beyond last completion */
+	elapsed = now - ts.time;
+	if (elapsed > ts.period_ticks)
+		elapsed = ts.period_ticks;
+
+	posn->dai_posn = ts.dai_posn +
+		elapsed * ts.period_bytes / ts.period_ticks;
+	posn->wallclock = now - ts.wallclock;
+	posn->timestamp = now;
+	posn->flags |= SOF_TIME_DAI_VALID | SOF_TIME_WALL_VALID |
+		SOF_TIME_WALL_64 | SOF_TIME_STAMP_VALID | SOF_TIME_STAMP_64;
+
+	return 1;
+}
+
 /*
  * Get the timestamps for host and first active DAI found.
  */
@@ -868,6 +938,10 @@ void pipeline_get_timestamp(struct pipeline *p, struct comp_dev *host,
 {
 	platform_host_timestamp(host, posn);
 
+	/* use DAI DMA completion record if we have one */
+	if (timestamp_interpolate(p, posn))
+		return;
+
 	if (host->params.direction == SOF_IPC_STREAM_PLAYBACK) {
 		timestamp_downstream(host, host, posn);
 	} else {
@@ -939,6 +1013,172 @@ static void pipeline_for_each_upstream(struct pipeline *p,
 	}
 }
 
+/* call func for each connected buffer downstream of current, the walk
+ * stops after buffers of other pipelines */
+static void pipeline_buffers_downstream(struct pipeline *p,
+	struct comp_dev *current,
+	void (*func)(struct comp_buffer *, void *), void *data)
+{
+	struct list_item *clist;
+	struct comp_buffer *buffer;
+
+	list_for_item(clist, &current->bsink_list) {
+		buffer = container_of(clist, struct comp_buffer, source_list);
+
+		if (!buffer->connected)
+			continue;
+
+		func(buffer, data);
+
+		if (buffer->ipc_buffer.comp.pipeline_id ==
+			p->ipc_pipe.pipeline_id)
+			pipeline_buffers_downstream(p, buffer->sink, func, data);
+	}
+}
+
+/* call func for each connected buffer upstream of current */
+static void pipeline_buffers_upstream(struct pipeline *p,
+	struct comp_dev *current,
+	void (*func)(struct comp_buffer *, void *), void *data)
+{
+	struct list_item *clist;
+	struct comp_buffer *buffer;
+
+	list_for_item(clist, &current->bsource_list) {
+		buffer = container_of(clist, struct comp_buffer, sink_list);
+
+		if (!buffer->connected)
+			continue;
+
+		func(buffer, data);
+
+		if (buffer->ipc_buffer.comp.pipeline_id ==
+			p->ipc_pipe.pipeline_id)
+			pipeline_buffers_upstream(p, buffer->source, func, data);
+	}
+}
+
+static void fill_window(struct comp_buffer *buffer, void *data)
+{
+	struct pipeline *p = data;
+
+	/* buffers on the edge are done by their own pipeline */
+	if (buffer->ipc_buffer.comp.pipeline_id == p->ipc_pipe.pipeline_id)
+		buffer_fill_window(buffer);
+}
+
+static void xrun_add_comp(struct sof_ipc_trace_xrun_reply *r,
+	struct comp_dev *dev)
+{
+	uint32_t i;
+
+	for (i = 0; i < r->num_comps; i++) {
+		if (r->comp[i].comp_id == dev->comp.id)
+			return;
+	}
+
+	if (r->num_comps == SOF_IPC_XRUN_MAX_COMPS)
+		return;
+
+	r->comp[i].comp_id = dev->comp.id;
+	r->comp[i].type = dev->comp.type;
+	r->comp[i].state = dev->state;
+	r->num_comps++;
+}
+
+static void xrun_add_buffer(struct comp_buffer *buffer, void *data)
+{
+	struct sof_ipc_trace_xrun_reply *r = data;
+	struct sof_ipc_xrun_buffer *b;
+	uint32_t flags;
+
+	if (r->num_buffers < SOF_IPC_XRUN_MAX_BUFFERS) {
+		b = &r->buffer[r->num_buffers++];
+
+		/* IRQs are only off while each buffer's levels are copied */
+		spin_lock_irq(&pipe_data->lock, flags);
+		b->comp_id = buffer->ipc_buffer.comp.id;
+		b->size = buffer->size;
+		b->avail = buffer->avail;
+		b->min = buffer->fill_min;
+		b->max = buffer->fill_max;
+		b->last_min = buffer->last_min;
+		b->last_max = buffer->last_max;
+		spin_unlock_irq(&pipe_data->lock, flags);
+	}
+
+	xrun_add_comp(r, buffer->source);
+	xrun_add_comp(r, buffer->sink);
+}
+
+/*
+ * Freeze pipeline state into the post-mortem record unless it's in use. The
+ * first XRUN claims the record under the lock and then walks the graph with
+ * IRQs on, later XRUNs only count.
+ */
+static void pipeline_xrun_record(struct pipeline *p, struct comp_dev *dev,
+	int32_t bytes)
+{
+	struct sof_ipc_trace_xrun_reply *r = &pipe_data->xrun;
+	uint32_t flags;
+
+	spin_lock_irq(&pipe_data->lock, flags);
+	if (r->count++) {
+		spin_unlock_irq(&pipe_data->lock, flags);
+		return;
+	}
+	pipe_data->xrun_filling = 1;
+	spin_unlock_irq(&pipe_data->lock, flags);
+
+	r->pipeline_id = p->ipc_pipe.pipeline_id;
+	r->comp_id = dev->comp.id;
+	r->xrun_size = bytes;
+	r->direction = dev->params.direction;
+	r->time = platform_timer_get_low();
+
+	r->task_state = p->pipe_task.state;
+	r->task_start = p->run_start;
+	r->task_ticks = p->run_ticks;
+	r->task_deadline = (uint32_t)p->pipe_task.deadline;
+	r->load = p->load.load;
+	r->peak = p->load.peak;
+
+	spin_lock_irq(&p->tstamp_lock, flags);
+	if (p->tstamp.valid) {
+		r->dma_time = (uint32_t)p->tstamp.time;
+		r->dma_period_ticks = p->tstamp.period_ticks;
+	} else {
+		r->dma_time = 0;
+		r->dma_period_ticks = 0;
+	}
+	spin_unlock_irq(&p->tstamp_lock, flags);
+
+	r->num_buffers = 0;
+	r->num_comps = 0;
+	xrun_add_comp(r, p->sched_comp);
+	pipeline_buffers_downstream(p, p->sched_comp, xrun_add_buffer, r);
+	pipeline_buffers_upstream(p, p->sched_comp, xrun_add_buffer, r);
+
+	spin_lock_irq(&pipe_data->lock, flags);
+	pipe_data->xrun_filling = 0;
+	spin_unlock_irq(&pipe_data->lock, flags);
+}
+
+/* record being taken is reported as no record and stays armed */
+void pipeline_get_xrun(struct sof_ipc_trace_xrun_reply *reply)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&pipe_data->lock, flags);
+	if (pipe_data->xrun_filling) {
+		bzero(reply, sizeof(*reply));
+	} else {
+		*reply = pipe_data->xrun;
+		pipe_data->xrun.count = 0;
+	}
+	spin_unlock_irq(&pipe_data->lock, flags);
+}
+
 /*
  * Send an XRUN to each host for this component.
  */
@@ -947,6 +1187,8 @@ void pipeline_xrun(struct pipeline *p, struct comp_dev *dev,
 {
 	struct sof_ipc_stream_posn posn;
 
+	pipeline_xrun_record(p, dev, bytes);
+
 	/* dont flood host */
 	if (p->xrun_bytes)
 		return;
@@ -982,15 +1224,26 @@ static void pipeline_task(void *arg)
 {
 	struct pipeline *p = arg;
 	struct comp_dev *dev = p->sched_comp;
+	struct load_frame frame;
 
 	tracev_pipe("PWs");
+	load_frame_begin(&frame);
+	p->run_start = frame.start;
 
 	/* copy data from upstream source enpoints to downstream endpoints */
 	pipeline_copy_from_upstream(dev, dev);
 	pipeline_copy_to_downstream(dev, dev);
 
+	p->run_ticks = load_frame_end(&frame, &p->load);
 	tracev_pipe("PWe");
 
+	/* start next buffer fill level window */
+	if (frame.start - p->fill_start >= p->fill_ticks) {
+		p->fill_start = frame.start;
+		pipeline_buffers_downstream(p, dev, fill_window, p);
+		pipeline_buffers_upstream(p, dev, fill_window, p);
+	}
+
 	/* now reschedule the task */
 	/* TODO: add in scheduling cost and any timer drift */
 	if (p->ipc_pipe.timer)
@@ -168,6 +168,9 @@ struct dma_chan_data {
 	uint32_t cfg_hi;
 	struct dma *dma;
 	int32_t channel;
+	uint32_t class;		/* DMAC class for the channel priority */
+	uint32_t err_restart;	/* restarted after an error, no good block yet */
+	struct dma_chan_stats stats;
 
 	void (*cb)(void *data, uint32_t type, struct dma_sg_elem *next);	/* client callback function */
 	void *cb_data;		/* client callback data */
@@ -177,9 +180,17 @@ struct dma_chan_data {
 /* private data for DW DMA engine */
 struct dma_pdata {
 	struct dma_chan_data chan[DW_MAX_CHAN];
-	uint32_t class;		/* channel class - set for controller atm */
 };
 
+#if defined CONFIG_BAYTRAIL || defined CONFIG_CHERRYTRAIL
+/* map DMA_PRIO_ to DMAC channel class */
+static const uint32_t dw_prio_class[DMA_PRIO_COUNT] = {
+	DW_CLASS_PRIO_LOW,
+	DW_CLASS_PRIO_NORMAL,
+	DW_CLASS_PRIO_HIGH,
+};
+#endif
+
 static inline void dw_dma_chan_reload_lli(struct dma *dma, int channel);
 static inline void dw_dma_chan_reload_next(struct dma *dma, int channel,
 		struct dma_sg_elem *next);
@@ -201,24 +212,42 @@ static inline void dw_update_bits(struct dma *dma, uint32_t reg, uint32_t mask,
 }
 
 /* allocate next free DMA channel */
-static int dw_dma_channel_get(struct dma *dma)
+static int dw_dma_channel_get(struct dma *dma, int prio)
 {
 	struct dma_pdata *p = dma_get_drvdata(dma);
 	uint32_t flags;
-	int i;
+	int i, j;
+
+	if (prio < DMA_PRIO_LOW || prio >= DMA_PRIO_COUNT) {
+		trace_dma_error("eDp");
+		return -EINVAL;
+	}
 
 	spin_lock_irq(&dma->lock, flags);
 
 	trace_dma("Dgt");
 
-	/* find first free non draining channel */
-	for (i = 0; i < DW_MAX_CHAN; i++) {
+	/* find first free non draining channel. Higher channel numbers win
+	 * DMAC arbitration between equal classes so high priority users
+	 * search downwards and everyone else searches upwards.
+	 */
+	for (j = 0; j < DW_MAX_CHAN; j++) {
+
+		i = prio == DMA_PRIO_HIGH ? DW_MAX_CHAN - 1 - j : j;
 
 		/* use channel if it's free */
 		if (p->chan[i].status != COMP_STATE_READY)
 			continue;
 
 		p->chan[i].status = COMP_STATE_PREPARE;
+#if defined CONFIG_BAYTRAIL || defined CONFIG_CHERRYTRAIL
+		p->chan[i].class = dw_prio_class[prio];
+#endif
+
+		/* reset channel statistics */
+		p->chan[i].err_restart = 0;
+		bzero(&p->chan[i].stats, sizeof(p->chan[i].stats));
+		p->chan[i].stats.prio = prio;
 
 		/* unmask block, transfer and error interrupts for channel */
 		dw_write(dma, DW_MASK_TFR, INT_UNMASK(i));
@@ -427,6 +456,24 @@ static int dw_dma_status(struct dma *dma, int channel,
 	return 0;
 }
 
+/* fill in "stats" with channel usage counters */
+static int dw_dma_stats(struct dma *dma, int channel,
+	struct dma_chan_stats *stats)
+{
+	struct dma_pdata *p = dma_get_drvdata(dma);
+	uint32_t flags;
+
+	if (channel < 0 || channel >= DW_MAX_CHAN)
+		return -EINVAL;
+
+	spin_lock_irq(&dma->lock, flags);
+	*stats = p->chan[channel].stats;
+	stats->state = p->chan[channel].status;
+	spin_unlock_irq(&dma->lock, flags);
+
+	return 0;
+}
+
 /* set the DMA channel configuration, source/target address, buffer sizes */
 static int dw_dma_set_config(struct dma *dma, int channel,
 	struct dma_sg_config *config)
@@ -443,7 +490,12 @@ static int dw_dma_set_config(struct dma *dma, int channel,
 
 	/* default channel config */
 	p->chan[channel].direction = config->direction;
+#if defined CONFIG_BAYTRAIL || defined CONFIG_CHERRYTRAIL
+	p->chan[channel].cfg_lo = DW_CFG_LOW_DEF |
+		DW_CFG_CH_PRIOR(p->chan[channel].class);
+#else
 	p->chan[channel].cfg_lo = DW_CFG_LOW_DEF;
+#endif
 	p->chan[channel].cfg_hi = DW_CFG_HIGH_DEF;
 
 	/* get number of SG elems */
@@ -547,7 +599,7 @@ static int dw_dma_set_config(struct dma *dma, int channel,
 		}
 		/* set transfer size of element */
 #if defined CONFIG_BAYTRAIL || defined CONFIG_CHERRYTRAIL
-		lli_desc->ctrl_hi = DW_CTLH_CLASS(p->class) |
+		lli_desc->ctrl_hi = DW_CTLH_CLASS(p->chan[channel].class) |
 			(sg_elem->size & DW_CTLH_BLOCK_TS_MASK);
 #else
 		/* for the unit is transaction--TR_WIDTH. */
@@ -654,7 +706,7 @@ static inline void dw_dma_chan_reload_next(struct dma *dma, int channel,
 
 	/* set transfer size of element */
 #if defined CONFIG_BAYTRAIL || defined CONFIG_CHERRYTRAIL
-	lli->ctrl_hi = DW_CTLH_CLASS(p->class) |
+	lli->ctrl_hi = DW_CTLH_CLASS(p->chan[channel].class) |
 		(next->size & DW_CTLH_BLOCK_TS_MASK);
 #else
 	/* for the unit is transaction--TR_WIDTH. */
@@ -674,14 +726,94 @@ static inline void dw_dma_chan_reload_next(struct dma *dma, int channel,
 	dw_write(dma, DW_DMA_CHAN_EN, CHAN_ENABLE(channel));
 }
 
+/* get the number of bytes moved by the current block */
+static inline uint32_t dw_dma_block_bytes(struct dw_lli2 *lli)
+{
+#if defined CONFIG_BAYTRAIL || defined CONFIG_CHERRYTRAIL
+	return lli->ctrl_hi & DW_CTLH_BLOCK_TS_MASK;
+#else
+	return (lli->ctrl_hi & DW_CTLH_BLOCK_TS_MASK) <<
+		(lli->ctrl_lo >> 4 & 0x7);
+#endif
+}
+
+/* update reload latency statistics for channel */
+static inline void dw_dma_stats_reload(struct dma_chan_data *chan,
+	uint64_t irq_time)
+{
+	uint32_t delta = (uint32_t)(timer_get_system(NULL) - irq_time);
+
+	chan->stats.reload_last = delta;
+	if (delta > chan->stats.reload_max)
+		chan->stats.reload_max = delta;
+}
+
+/* disable a channel that has raised an error and wait for it to stop */
+static inline void dw_dma_chan_disable(struct dma *dma, int channel)
+{
+	int i;
+
+	dw_write(dma, DW_DMA_CHAN_EN, CHAN_DISABLE(channel));
+
+	for (i = DW_DMA_CFG_TRIES; i > 0; i--) {
+		if (!(dw_read(dma, DW_DMA_CHAN_EN) & (0x1 << channel)))
+			return;
+	}
+
+	trace_dma_error("eDd");
+}
+
+/* block completed or failed - ask client for next block and reload */
+static void dw_dma_chan_complete(struct dma *dma, int channel,
+	uint32_t type, uint64_t irq_time)
+{
+	struct dma_pdata *p = dma_get_drvdata(dma);
+	struct dma_chan_data *chan = &p->chan[channel];
+	struct dma_sg_elem next;
+
+	/* will reload lli by default, an error straight after an error
+	 * restart is reported with DMA_RELOAD_END as the restart failed
+	 */
+	next.size = DMA_RELOAD_LLI;
+	if (type == DMA_IRQ_TYPE_ERROR) {
+		if (chan->err_restart)
+			next.size = DMA_RELOAD_END;
+		chan->err_restart = 1;
+	}
+
+	/* errors are always reported, clients must not miss a lost block */
+	if (chan->cb && ((chan->cb_type & type) || type == DMA_IRQ_TYPE_ERROR))
+		chan->cb(chan->cb_data, type, &next);
+
+	/* check for reload channel:
+	 * next.size is DMA_RELOAD_END, stop this dma copy;
+	 * next.size > 0 but not DMA_RELOAD_LLI, use next
+	 * element for next copy;
+	 * if we are waiting for pause, pause it;
+	 * otherwise, reload lli
+	 */
+	if (next.size == DMA_RELOAD_END) {
+		chan->status = COMP_STATE_PREPARE;
+		return;
+	} else if (next.size != DMA_RELOAD_LLI)
+		dw_dma_chan_reload_next(dma, channel, &next);
+	/* reload lli, but let's check if we are pausing first */
+	else if (chan->status == COMP_STATE_PAUSED)
+		return;
+	else
+		dw_dma_chan_reload_lli(dma, channel);
+
+	dw_dma_stats_reload(chan, irq_time);
+}
+
 /* this will probably be called at the end of every period copied */
 static void dw_dma_irq_handler(void *data)
 {
 	struct dma *dma = (struct dma *)data;
 	struct dma_pdata *p = dma_get_drvdata(dma);
-	struct dma_sg_elem next;
 	uint32_t status_tfr = 0, status_block = 0, status_err = 0, status_intr;
 	uint32_t mask, pmask;
+	uint64_t irq_time = timer_get_system(NULL);
 	int i;
 
 	status_intr = dw_read(dma, DW_INTR_STATUS);
@@ -698,11 +830,12 @@ static void dw_dma_irq_handler(void *data)
 	dw_write(dma, DW_CLEAR_BLOCK, status_block);
 	dw_write(dma, DW_CLEAR_TFR, status_tfr);
 
-	/* TODO: handle errors, just clear them atm */
+	/* errors are recovered per channel below */
 	status_err = dw_read(dma, DW_STATUS_ERR);
 	dw_write(dma, DW_CLEAR_ERR, status_err);
 	if (status_err) {
 		trace_dma_error("eDi");
+		trace_value(status_err);
 	}
 
 	/* clear platform and DSP interrupt */
@@ -722,34 +855,31 @@ static void dw_dma_irq_handler(void *data)
 
 		mask = 0x1 << i;
 
+		/* transfer error - drop the failed block and tell the client
+		 * the block was lost. The channel is restarted at the next
+		 * period boundary unless the client ends the transfer.
+		 */
+		if (status_err & mask) {
+			p->chan[i].stats.errors++;
+			dw_dma_chan_disable(dma, i);
+			dw_dma_chan_complete(dma, i, DMA_IRQ_TYPE_ERROR,
+				irq_time);
+			continue;
+		}
+
+		if (status_tfr & mask) {
+			p->chan[i].err_restart = 0;
+			p->chan[i].stats.irqs++;
+			if (p->chan[i].lli_current)
+				p->chan[i].stats.bytes +=
+					dw_dma_block_bytes(p->chan[i].lli_current);
+		}
+
 		/* end of a transfer */
 		if ((status_tfr & mask) &&
-			(p->chan[i].cb_type & DMA_IRQ_TYPE_LLIST)) {
-
-			next.size = DMA_RELOAD_LLI; /* will reload lli by default */
-			if (p->chan[i].cb)
-				p->chan[i].cb(p->chan[i].cb_data,
-					DMA_IRQ_TYPE_LLIST, &next);
-
-			/* check for reload channel:
-			 * next.size is DMA_RELOAD_END, stop this dma copy;
-			 * next.size > 0 but not DMA_RELOAD_LLI, use next
-			 * element for next copy;
-			 * if we are waiting for pause, pause it;
-			 * otherwise, reload lli
-			 */
-			if (next.size == DMA_RELOAD_END) {
-				p->chan[i].status = COMP_STATE_PREPARE;
-				continue;
-			}
-			else if (next.size != DMA_RELOAD_LLI)
-				dw_dma_chan_reload_next(dma, i, &next);
-			/* reload lli, but let's check if we are pausing first */
-			else if (p->chan[i].status == COMP_STATE_PAUSED) {
-				continue;
-			} else
-				dw_dma_chan_reload_lli(dma, i);
-		}
+			(p->chan[i].cb_type & DMA_IRQ_TYPE_LLIST))
+			dw_dma_chan_complete(dma, i, DMA_IRQ_TYPE_LLIST,
+				irq_time);
 #if DW_USE_HW_LLI
 		/* end of a LLI block */
 		if (status_block & mask &&
@@ -820,6 +950,7 @@ found:
 
 static int dw_dma_probe(struct dma *dma)
 {
+	struct dw_drv_plat_data *dp = dma->plat_data.drv_plat_data;
 	struct dma_pdata *dw_pdata;
 	int i;
 
@@ -835,6 +966,7 @@ static int dw_dma_probe(struct dma *dma)
 	for (i = 0; i < DW_MAX_CHAN; i++) {
 		dw_pdata->chan[i].dma = dma;
 		dw_pdata->chan[i].channel = i;
+		dw_pdata->chan[i].class = dp->chan[i].class;
 		dw_pdata->chan[i].status = COMP_STATE_READY;
 	}
 
@@ -853,6 +985,7 @@ const struct dma_ops dw_dma_ops = {
 	.pause		= dw_dma_pause,
 	.release	= dw_dma_release,
 	.status		= dw_dma_status,
+	.stats		= dw_dma_stats,
 	.set_config	= dw_dma_set_config,
 	.set_cb		= dw_dma_set_cb,
 	.pm_context_restore		= dw_dma_pm_context_restore,
@@ -61,6 +61,12 @@ struct comp_buffer {
 	void *addr;		/* buffer base address */
 	void *end_addr;		/* buffer end address */
 
+	/* fill level telemetry in bytes available */
+	uint32_t fill_min;	/* current window */
+	uint32_t fill_max;
+	uint32_t last_min;	/* last complete window */
+	uint32_t last_max;
+
 	/* IPC configuration */
 	struct sof_ipc_buffer ipc_buffer;
 
@@ -106,6 +112,9 @@ static inline void comp_update_buffer_produce(struct comp_buffer *buffer,
 	/* calculate free bytes */
 	buffer->free = buffer->size - buffer->avail;
 
+	if (buffer->avail > buffer->fill_max)
+		buffer->fill_max = buffer->avail;
+
 	tracev_buffer("pro");
 	tracev_value((buffer->avail << 16) | buffer->free);
 	tracev_value((buffer->ipc_buffer.comp.id << 16) | buffer->size);
@@ -141,6 +150,9 @@ static inline void comp_update_buffer_consume(struct comp_buffer *buffer,
 	/* calculate free bytes */
 	buffer->free = buffer->size - buffer->avail;
 
+	if (buffer->avail < buffer->fill_min)
+		buffer->fill_min = buffer->avail;
+
 	tracev_buffer("con");
 	tracev_value((buffer->avail << 16) | buffer->free);
 	tracev_value((buffer->ipc_buffer.comp.id << 16) | buffer->size);
@@ -170,6 +182,16 @@ static inline void buffer_reset_pos(struct comp_buffer *buffer)
 	buffer->w_ptr = buffer->addr;
 	buffer->free = buffer->size;
 	buffer->avail = 0;
+	buffer->fill_min = buffer->fill_max = 0;
+	buffer->last_min = buffer->last_max = 0;
+}
+
+/* close fill level window and start the next at the current level */
+static inline void buffer_fill_window(struct comp_buffer *buffer)
+{
+	buffer->last_min = buffer->fill_min;
+	buffer->last_max = buffer->fill_max;
+	buffer->fill_min = buffer->fill_max = buffer->avail;
 }
 
 static inline void buffer_clear(struct comp_buffer *buffer)
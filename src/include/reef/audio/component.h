@@ -39,6 +39,8 @@
 #include <reef/reef.h>
 #include <reef/alloc.h>
 #include <reef/dma.h>
+#include <reef/perf.h>
+#include <reef/profile.h>
 #include <reef/stream.h>
 #include <reef/audio/buffer.h>
 #include <reef/audio/pipeline.h>
@@ -145,9 +147,9 @@ struct comp_ops {
 	/* copy and process stream data from source to sink buffers */
 	int (*copy)(struct comp_dev *dev);
 
-	/* host buffer config */
-	int (*host_buffer)(struct comp_dev *dev, struct dma_sg_elem *elem,
-			uint32_t host_size);
+	/* host buffer config - takes ownership of elems array on success */
+	int (*host_buffer)(struct comp_dev *dev, struct dma_sg_elem *elems,
+			uint32_t count, uint32_t host_size);
 
 	/* position */
 	int (*position)(struct comp_dev *dev,
@@ -188,6 +190,9 @@ struct comp_dev {
 	struct list_item bsource_list;	/* list of source buffers */
 	struct list_item bsink_list;	/* list of sink buffers */
 
+	/* copy() performance counters */
+	struct perf_region perf;
+
 	/* private data - core does not touch this */
 	void *private;		/* private data */
 
@@ -235,10 +240,12 @@ static inline int comp_params(struct comp_dev *dev)
  * mandatory for host components, optional for the others.
  */
 static inline int comp_host_buffer(struct comp_dev *dev,
-	struct dma_sg_elem *elem, uint32_t host_size)
+	struct dma_sg_elem *elems, uint32_t count, uint32_t host_size)
 {
 	if (dev->drv->ops.host_buffer)
-		return dev->drv->ops.host_buffer(dev, elem, host_size);
+		return dev->drv->ops.host_buffer(dev, elems, count, host_size);
+
+	rbfree(elems);
 	return 0;
 }
 
@@ -263,7 +270,18 @@ static inline int comp_preload(struct comp_dev *dev)
 /* copy component buffers - mandatory */
 static inline int comp_copy(struct comp_dev *dev)
 {
-	return dev->drv->ops.copy(dev);
+	uint32_t ctx;
+	int ret;
+
+	trace_mark(TRACE_MARK_COPY_BEGIN, TRACE_MARK_COMP(dev));
+	ctx = profile_ctx_enter(TRACE_MARK_COMP(dev));
+	PERF_REGION_BEGIN(&dev->perf);
+	ret = dev->drv->ops.copy(dev);
+	PERF_REGION_END(&dev->perf);
+	profile_ctx_exit(ctx);
+	trace_mark(TRACE_MARK_COPY_END, TRACE_MARK_COMP(dev));
+
+	return ret;
 }
 
 /* component reset and free runtime resources -mandatory  */
@@ -40,30 +40,41 @@
 #include <reef/timer.h>
 #include <reef/dma.h>
 #include <reef/work.h>
+#include <reef/lock.h>
 #include <platform/platform.h>
 #include <platform/timer.h>
 
+/* one half of the ping-pong buffer */
 struct dma_trace_buf {
-	void *w_ptr;		/* buffer write pointer */
-	void *r_ptr;		/* buffer read position */
-	void *addr;		/* buffer base address */
-	void *end_addr;		/* buffer end address */
-	uint32_t size;		/* size of buffer in bytes */
+	void *addr;		/* half base address */
+	uint32_t used;		/* bytes written by dtrace_event() */
+	uint32_t sent;		/* bytes copied to host */
 };
 
 struct dma_trace_data {
 	struct dma_sg_config config;
-	struct dma_trace_buf dmatb;
+	struct dma_trace_buf half[2];
+	void *addr;		/* local buffer base address */
+	uint32_t half_size;
+	uint32_t fill;		/* half being filled, the other is sent */
+	uint32_t copy_size;	/* bytes in the DMA in flight, 0 when idle */
+	uint32_t overflow;	/* bytes dropped with both halves full */
+	uint32_t overflow_reported;
+	struct dma *dma;	/* DMAC and channel reserved for trace */
+	int chan;
+	spinlock_t lock;
 	int32_t host_offset;
 	uint32_t host_size;
+	struct dma_sg_elem *host_elems;	/* host SG elems from page table */
 	struct work dmat_work;
 };
 
 int dma_trace_init(struct dma_trace_data *d);
-int dma_trace_host_buffer(struct dma_trace_data *d, struct dma_sg_elem *elem,
-	uint32_t host_size);
+int dma_trace_host_buffer(struct dma_trace_data *d, struct dma_sg_elem *elems,
+	uint32_t count, uint32_t host_size);
 void dma_trace_config_ready(struct dma_trace_data *d);
 
 void dtrace_event(char *e);
+void dtrace_data(void *data, uint32_t size);
 
 #endif
@@ -40,6 +40,7 @@
 #include <reef/audio/component.h>
 #include <reef/trace.h>
 #include <reef/schedule.h>
+#include <reef/load.h>
 #include <uapi/ipc.h>
 
 /* pipeline tracing */
@@ -50,6 +51,16 @@
 struct ipc_pipeline_dev;
 struct ipc;
 
+/* DAI DMA completion record, latched in the DAI DMA IRQ */
+struct pipeline_dma_tstamp {
+	uint64_t time;		/* platform timer at DMA period completion */
+	uint64_t dai_posn;	/* DAI position in bytes at completion */
+	uint64_t wallclock;	/* DAI stream start wallclock */
+	uint32_t period_bytes;
+	uint32_t period_ticks;	/* platform timer ticks per period */
+	uint32_t valid;
+};
+
 /*
  * Audio pipeline.
  */
@@ -57,6 +68,10 @@ struct pipeline {
 	spinlock_t lock;
 	struct sof_ipc_pipe_new ipc_pipe;
 
+	/* DMA completion timestamps */
+	spinlock_t tstamp_lock;
+	struct pipeline_dma_tstamp tstamp;
+
 	/* runtime status */
 	int32_t xrun_bytes;		/* last xrun length */
 
@@ -67,6 +82,13 @@ struct pipeline {
 	/* scheduling */
 	struct task pipe_task;		/* pipeline processing task */
 	struct comp_dev *sched_comp;
+	struct load_window load;	/* DSP load of pipeline task */
+	uint32_t run_start;		/* last task run in platform ticks */
+	uint32_t run_ticks;
+
+	/* buffer fill level windows */
+	uint32_t fill_start;
+	uint32_t fill_ticks;
 };
 
 /* static pipeline */
@@ -119,6 +141,14 @@ void pipeline_schedule_cancel(struct pipeline *p);
 void pipeline_get_timestamp(struct pipeline *p, struct comp_dev *host_dev,
 	struct sof_ipc_stream_posn *posn);
 
+/* copy XRUN post-mortem record and re-arm it */
+void pipeline_get_xrun(struct sof_ipc_trace_xrun_reply *reply);
+
+/* latch or clear DAI DMA completion timestamp */
+void pipeline_set_dma_tstamp(struct pipeline *p,
+	struct pipeline_dma_tstamp *tstamp);
+void pipeline_clear_dma_tstamp(struct pipeline *p);
+
 void pipeline_schedule(void *arg);
 
 /* notify host that we have XRUN */
@@ -48,7 +48,13 @@
 /* DMA IRQ types */
 #define DMA_IRQ_TYPE_BLOCK	(1 << 0)
 #define DMA_IRQ_TYPE_LLIST	(1 << 1)
+#define DMA_IRQ_TYPE_ERROR	(1 << 2)	/* block lost, always reported */
 
+/* DMA channel priority classes */
+#define DMA_PRIO_LOW		0	/* bulk copies - trace, page tables */
+#define DMA_PRIO_NORMAL		1	/* host stream copies */
+#define DMA_PRIO_HIGH		2	/* real time DAI streams */
+#define DMA_PRIO_COUNT		3
 
 /* We will use this macro in cb handler to inform dma that
  * we need to stop the reload for specail purpose
@@ -56,6 +62,12 @@
 #define DMA_RELOAD_END	0
 #define DMA_RELOAD_LLI	0xFFFFFFFF
 
+/*
+ * On DMA_IRQ_TYPE_ERROR the channel is restarted from the next block unless
+ * the client ends it. next->size is DMA_RELOAD_END on entry when the block
+ * after the last restart failed too, the channel is then not restarted.
+ */
+
 struct dma;
 
 struct dma_sg_elem {
@@ -84,10 +96,21 @@ struct dma_chan_status {
 	uint32_t timestamp;
 };
 
+/* DMA channel statistics - counters are reset on channel_get() */
+struct dma_chan_stats {
+	uint32_t prio;		/* DMA_PRIO_ */
+	uint32_t state;
+	uint64_t bytes;		/* bytes moved by completed blocks */
+	uint32_t irqs;		/* transfer IRQs */
+	uint32_t errors;	/* error IRQs */
+	uint32_t reload_last;	/* IRQ to channel reload in timer ticks */
+	uint32_t reload_max;
+};
+
 /* DMA operations */
 struct dma_ops {
 
-	int (*channel_get)(struct dma *dma);
+	int (*channel_get)(struct dma *dma, int prio);
 	void (*channel_put)(struct dma *dma, int channel);
 
 	int (*start)(struct dma *dma, int channel);
@@ -96,6 +119,8 @@ struct dma_ops {
 	int (*release)(struct dma *dma, int channel);
 	int (*status)(struct dma *dma, int channel,
 		struct dma_chan_status *status, uint8_t direction);
+	int (*stats)(struct dma *dma, int channel,
+		struct dma_chan_stats *stats);
 
 	int (*set_config)(struct dma *dma, int channel,
 		struct dma_sg_config *config);
@@ -149,9 +174,10 @@ struct dma *dma_get(int dmac_id);
  * 6) dma_channel_put()
  */
 
-static inline int dma_channel_get(struct dma *dma)
+/* get a free channel, prio is DMA_PRIO_ and sets channel bus priority */
+static inline int dma_channel_get(struct dma *dma, int prio)
 {
-	return dma->ops->channel_get(dma);
+	return dma->ops->channel_get(dma, prio);
 }
 
 static inline void dma_channel_put(struct dma *dma, int channel)
@@ -191,6 +217,12 @@ static inline int dma_status(struct dma *dma, int channel,
 	return dma->ops->status(dma, channel, status, direction);
 }
 
+static inline int dma_stats(struct dma *dma, int channel,
+	struct dma_chan_stats *stats)
+{
+	return dma->ops->stats(dma, channel, stats);
+}
+
 static inline int dma_set_config(struct dma *dma, int channel,
 	struct dma_sg_config *config)
 {
@@ -236,4 +268,11 @@ int dma_copy_from_host(struct dma_sg_config *host_sg,
 int dma_copy_to_host(struct dma_sg_config *host_sg,
 	int32_t host_offset, void *local_ptr, int32_t size);
 
+/* start DMA copy from DSP to host on a channel owned by the caller and
+ * return without waiting. Copies up to one host page, returns bytes started
+ * and completion is reported by the channel DMA_IRQ_TYPE_LLIST callback */
+int dma_copy_to_host_nowait(struct dma *dma, int chan,
+	struct dma_sg_config *host_sg, int32_t host_offset, void *local_ptr,
+	int32_t size);
+
 #endif
@@ -45,5 +45,6 @@ struct intel_ipc_data {
 };
 
 int ipc_cmd(void);
+int ipc_cmd_blocking(void);
 
 #endif
@@ -35,6 +35,7 @@
 #include <arch/interrupt.h>
 #include <reef/trace.h>
 #include <reef/debug.h>
+#include <reef/watermark.h>
 
 #define trace_irq(__e)	trace_event(TRACE_CLASS_IRQ | __e)
 
@@ -69,13 +70,26 @@ static inline void interrupt_clear(int irq)
 	arch_interrupt_clear(irq);
 }
 
+/* blocking waits use WAITI 0 so can only be done at level 0 */
+static inline uint32_t interrupt_get_level(void)
+{
+	return arch_interrupt_get_level();
+}
+
+/* PC interrupted by the interrupt being handled, level must be a constant */
+#define interrupt_get_pc(level)	arch_interrupt_get_pc(level)
+
 static inline uint32_t interrupt_global_disable(void)
 {
-	return arch_interrupt_global_disable();
+	uint32_t flags = arch_interrupt_global_disable();
+
+	watermark_irq_off(flags);
+	return flags;
 }
 
 static inline void interrupt_global_enable(uint32_t flags)
 {
+	watermark_irq_on(flags);
 	arch_interrupt_global_enable(flags);
 }
 
@@ -36,6 +36,7 @@
 #include <reef/trace.h>
 #include <reef/dai.h>
 #include <reef/lock.h>
+#include <reef/schedule.h>
 #include <platform/platform.h>
 #include <uapi/ipc.h>
 #include <reef/audio/pipeline.h>
@@ -51,14 +52,33 @@ struct dai_config;
 
 #define MSG_QUEUE_SIZE		12
 
+/* DSP to host message flags */
+#define IPC_MSG_COALESCE	(1 << 0)	/* replace queued msg with same id */
+#define IPC_MSG_URGENT		(1 << 1)	/* send ahead of routine msgs */
+#define IPC_MSG_BATCH		(1 << 2)	/* can share a mailbox write */
+
 #define COMP_TYPE_COMPONENT	1
 #define COMP_TYPE_BUFFER	2
 #define COMP_TYPE_PIPELINE	3
+#define COMP_TYPE_COUNT		3
+
+/* ID hash buckets per type, must be power of 2 */
+#define IPC_COMP_HASH_SIZE	32
+
+/* topology snapshot record - copy of an IPC message that built the graph */
+struct ipc_snap_rec {
+	struct list_item list;
+	uint16_t dep_type[2];	/* COMP_TYPE_ of objects message uses or 0 */
+	uint32_t dep_id[2];	/* host IDs of objects message uses */
+	uint32_t key;		/* control key, later sets replace record */
+	uint32_t msg[0];	/* message, starts with struct sof_ipc_hdr */
+};
 
 /* IPC generic component device */
 struct ipc_comp_dev {
 	uint16_t type;	/* COMP_TYPE_ */
 	uint16_t state;
+	uint32_t id;	/* host ID, unique per type */
 
 	/* component type data */
 	union {
@@ -69,10 +89,38 @@ struct ipc_comp_dev {
 
 	/* lists */
 	struct list_item list;		/* list in components */
+	struct list_item hash_list;	/* list in ID hash bucket */
+};
+
+/* host command statistics for each SOF_IPC_GLB_ type */
+#define IPC_STATS_CLASSES	10
+#define IPC_STATS_BIN_SHIFT	10
+
+struct ipc_cmd_stats {
+	uint32_t count;
+	uint32_t errors;
+	uint32_t queue_max;
+	uint32_t exec_max;
+	uint32_t hist[SOF_IPC_STATS_BINS];
+};
+
+struct ipc_stats {
+	struct ipc_cmd_stats cmd[IPC_STATS_CLASSES];
+
+	/* DSP to host messages */
+	uint32_t tx_depth;
+	uint32_t tx_depth_max;
+	uint32_t tx_count;
+	uint32_t tx_coalesced;
+	uint32_t tx_dropped;
+	uint32_t tx_ack_max;
+	uint64_t tx_time;
 };
 
 struct ipc_msg {
 	uint32_t header;	/* specific to platform */
+	uint32_t id;		/* stream or component ID for coalescing */
+	uint32_t flags;		/* IPC_MSG_ */
 	uint32_t tx_size;	/* payload size in bytes */
 	uint8_t tx_data[SOF_IPC_MSG_MAX_SIZE];		/* pointer to payload data */
 	uint32_t rx_size;	/* payload size in bytes */
@@ -85,24 +133,45 @@ struct ipc_msg {
 struct ipc {
 	/* messaging */
 	uint32_t host_msg;		/* current message from host */
+	uint32_t host_offset;		/* hostbox offset of current command */
+	uint32_t host_size;		/* hostbox bytes for command and reply */
+	uint32_t rx_pending;		/* inbound ring has been kicked */
+	uint32_t rx_next;		/* next ring slot to run */
+	uint64_t host_rx_time;		/* doorbell time of current command */
+	uint64_t rx_time[SOF_IPC_RX_RING_SLOTS];	/* doorbell time of slot */
+	uint32_t rx_stamped;		/* slots from rx_next with a time */
 	struct ipc_msg *dsp_msg;		/* current message to host */
 	uint32_t host_pending;
 	uint32_t dsp_pending;
+	uint32_t idle_pending;		/* blocking command left for idle loop */
 	struct list_item msg_list;
 	struct list_item empty_list;
 	spinlock_t lock;
 	struct ipc_msg message[MSG_QUEUE_SIZE];
 	void *comp_data;
 
+	/* commands and notifications are run by a low priority task */
+	struct task ipc_task;
+
 	/* RX call back */
 	int (*cb)(struct ipc_msg *msg);
 
 	/* pipelines, components and buffers */
 	struct list_item comp_list;		/* list of component devices */
+	struct list_item comp_hash[COMP_TYPE_COUNT][IPC_COMP_HASH_SIZE];
+
+	/* topology snapshot for PM context save and restore */
+	struct list_item snap_list;		/* list of ipc_snap_rec */
+	uint32_t snap_count;			/* messages in snapshot */
+	uint32_t snap_bytes;			/* message bytes in snapshot */
+	uint32_t snap_invalid;			/* a record was lost */
 
 	/* DMA for Trace*/
 	struct dma_trace_data dmat;
 
+	/* IPC statistics */
+	struct ipc_stats stats;
+
 	void *private;
 };
 
@@ -117,6 +186,7 @@ int platform_ipc_init(struct ipc *ipc);
 void ipc_free(struct ipc *ipc);
 
 int ipc_process_msg_queue(void);
+void ipc_schedule_process(struct ipc *ipc);
 
 int ipc_stream_send_position(struct comp_dev *cdev,
 		struct sof_ipc_stream_posn *posn);
@@ -126,10 +196,17 @@ int ipc_stream_send_xrun(struct comp_dev *cdev,
 int ipc_queue_host_message(struct ipc *ipc, uint32_t header,
 	void *tx_data, size_t tx_bytes, void *rx_data,
 	size_t rx_bytes, void (*cb)(void*, void*), void *cb_data);
+int ipc_queue_host_notify(struct ipc *ipc, uint32_t header, uint32_t id,
+	uint32_t flags, void *tx_data, size_t tx_bytes);
 int ipc_send_short_msg(uint32_t msg);
 
+void ipc_stats_tx_sent(struct ipc *ipc, uint32_t count);
+void ipc_stats_tx_ack(struct ipc *ipc);
+
 void ipc_platform_do_cmd(struct ipc *ipc);
 void ipc_platform_send_msg(struct ipc *ipc);
+int ipc_platform_send_direct(struct ipc *ipc, struct ipc_msg *msg,
+	void *tx_data);
 
 /*
  * IPC Component creation and destruction.
@@ -160,6 +237,16 @@ int ipc_comp_connect(struct ipc *ipc,
  * Get component by ID.
  */
 struct ipc_comp_dev *ipc_get_comp(struct ipc *ipc, uint32_t id);
+struct ipc_comp_dev *ipc_get_comp_type(struct ipc *ipc, uint16_t type,
+	uint32_t id);
+
+/*
+ * Topology snapshot of the constructed graph and control values.
+ */
+void ipc_snap_ctrl(struct ipc *ipc, uint32_t cmd,
+	struct sof_ipc_ctrl_data *data);
+uint32_t ipc_snap_size(struct ipc *ipc);
+int ipc_snap_write(struct ipc *ipc, void *data, uint32_t size);
 
 /*
  * Configure all DAI components attached to DAI.
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * DSP load accounting.
+ */
+
+#ifndef __INCLUDE_LOAD__
+#define __INCLUDE_LOAD__
+
+#include <stdint.h>
+#include <reef/list.h>
+#include <uapi/ipc.h>
+
+/* load window period */
+#define LOAD_WINDOW_US	100000
+
+/* loads are in 0.1% of DSP time */
+#define LOAD_SCALE	1000
+
+/* load of a pipeline or other client over the last window */
+struct load_window {
+	struct list_item list;
+	uint32_t id;
+	uint32_t busy;		/* ticks in current window */
+	uint32_t load;		/* last complete window */
+	uint32_t peak;
+};
+
+/* busy section, nested sections are not counted in their parent */
+struct load_frame {
+	uint32_t start;
+	uint32_t child;		/* parent child ticks at frame start */
+};
+
+void load_frame_begin(struct load_frame *frame);
+uint32_t load_frame_end(struct load_frame *frame,
+	struct load_window *window);
+
+/* idle time is only counted by the main loop around WAITI */
+void load_idle_begin(void);
+void load_idle_end(void);
+
+void load_window_register(struct load_window *window, uint32_t id);
+void load_window_unregister(struct load_window *window);
+
+void load_report(struct sof_ipc_trace_load_reply *reply, uint32_t reset_peak);
+
+void load_init(void);
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * Code region profiling with the CPU performance counters.
+ */
+
+#ifndef __INCLUDE_PERF__
+#define __INCLUDE_PERF__
+
+#include <stdint.h>
+
+/* move to config.h */
+#define PERF	1
+
+/* counted events, not all cores can count all of them */
+#define PERF_CYCLES		0
+#define PERF_INSTR		1	/* committed instructions */
+#define PERF_ICACHE_MISS	2
+#define PERF_DCACHE_MISS	3	/* data cache load misses */
+#define PERF_EVENTS		4
+
+/* region is reported and cleared after this many runs, keeps the cycle
+ * totals in 32 bits for regions up to 16M cycles */
+#define PERF_REPORT_RUNS	256
+
+struct perf_region {
+	uint32_t id;			/* reported with each record */
+	uint32_t start[PERF_EVENTS];	/* counts at region begin */
+	uint32_t total[PERF_EVENTS];	/* counts since last report */
+	uint32_t max_cycles;		/* longest run since last report */
+	uint32_t runs;			/* runs since last report */
+};
+
+#if PERF && defined(__XTENSA__)
+
+#include <arch/perf.h>
+
+void perf_region_report(struct perf_region *r);
+
+static inline void perf_init(void)
+{
+	arch_perf_init();
+}
+
+/* supported events as a bitmask of 1 << PERF_ */
+static inline uint32_t perf_events(void)
+{
+	return arch_perf_events();
+}
+
+static inline void perf_region_init(struct perf_region *r, uint32_t id)
+{
+	int i;
+
+	r->id = id;
+	r->max_cycles = 0;
+	r->runs = 0;
+	for (i = 0; i < PERF_EVENTS; i++)
+		r->total[i] = 0;
+}
+
+static inline void perf_region_begin(struct perf_region *r)
+{
+	arch_perf_read(r->start);
+}
+
+/* counters are free running, unsigned deltas handle wraps */
+static inline void perf_region_end(struct perf_region *r)
+{
+	uint32_t count[PERF_EVENTS];
+	uint32_t delta;
+	int i;
+
+	arch_perf_read(count);
+
+	for (i = 0; i < PERF_EVENTS; i++) {
+		delta = count[i] - r->start[i];
+		r->total[i] += delta;
+		if (i == PERF_CYCLES && delta > r->max_cycles)
+			r->max_cycles = delta;
+	}
+
+	if (++r->runs >= PERF_REPORT_RUNS)
+		perf_region_report(r);
+}
+
+#define PERF_REGION_INIT(__r, __id)	perf_region_init(__r, __id)
+#define PERF_REGION_BEGIN(__r)		perf_region_begin(__r)
+#define PERF_REGION_END(__r)		perf_region_end(__r)
+
+#else
+
+static inline void perf_init(void) {}
+static inline uint32_t perf_events(void) { return 0; }
+
+#define PERF_REGION_INIT(__r, __id)	do {} while (0)
+#define PERF_REGION_BEGIN(__r)		do {} while (0)
+#define PERF_REGION_END(__r)		do {} while (0)
+
+#endif
+
+#endif
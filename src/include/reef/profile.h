@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ */
+
+#ifndef __INCLUDE_PROFILE__
+#define __INCLUDE_PROFILE__
+
+#include <stdint.h>
+#include <errno.h>
+#include <uapi/trace.h>
+
+/* move to config.h */
+#define PROFILE	1
+
+#if PROFILE
+
+/* context of the running code, read by the profiler sample IRQ */
+extern volatile uint32_t profile_ctx;
+
+static inline uint32_t profile_ctx_enter(uint32_t ctx)
+{
+	uint32_t prev = profile_ctx;
+
+	profile_ctx = ctx;
+	return prev;
+}
+
+static inline void profile_ctx_exit(uint32_t prev)
+{
+	profile_ctx = prev;
+}
+
+int profile_start(uint32_t rate_hz, uint32_t report_ms);
+void profile_stop(void);
+
+#else
+
+static inline uint32_t profile_ctx_enter(uint32_t ctx)
+{
+	return TRACE_PROFILE_CTX_NONE;
+}
+
+static inline void profile_ctx_exit(uint32_t prev) {}
+
+static inline int profile_start(uint32_t rate_hz, uint32_t report_ms)
+{
+	return -ENODEV;
+}
+
+static inline void profile_stop(void) {}
+
+#endif
+
+#endif
@@ -49,6 +49,7 @@ struct reef;
 #define TASK_STATE_COMPLETED	4
 #define TASK_STATE_FREE		5
 #define TASK_STATE_CANCEL	6
+#define TASK_STATE_RERUN	7	/* queued again while running */
 
 /* task priorities - values same as Linux processes, gives scope for future.*/
 #define TASK_PRI_LOW	19
@@ -59,11 +60,13 @@ struct reef;
 /* task descriptor */
 struct task {
 	uint16_t core;			/* core id to run on */
+	uint32_t id;			/* trace marker ID */
 	int16_t priority;		/* scheduling priority TASK_PRI_ */
 	uint64_t start;			/* scheduling earliest start time */
 	uint64_t deadline;		/* scheduling deadline */
 	uint32_t state;			/* TASK_STATE_ */
 	struct list_item list;		/* list in scheduler */
+	struct list_item irq_list;	/* list in task IRQ level */
 
 	/* task function and private data */
 	void *data;
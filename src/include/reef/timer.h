@@ -59,6 +59,16 @@ static inline int timer_set(struct timer *timer, uint64_t ticks)
 
 void timer_set_ms(struct timer *timer, unsigned int ms);
 
+static inline uint32_t timer_get_cycles(void)
+{
+	return arch_timer_get_cycles();
+}
+
+static inline int timer_set_compare(struct timer *timer, uint32_t cycles)
+{
+	return arch_timer_set_compare(timer, cycles);
+}
+
 static inline void timer_clear(struct timer *timer)
 {
 	arch_timer_clear(timer);
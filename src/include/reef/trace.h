@@ -40,6 +40,7 @@
 #include <reef/timer.h>
 #include <platform/platform.h>
 #include <platform/timer.h>
+#include <uapi/trace.h>
 
 /* general trace init codes - only used at boot when main trace is not availble */
 #define TRACE_BOOT_START	0x1000
@@ -87,29 +88,82 @@
 #define TRACE_CLASS_TONE        (18 << 24)
 #define TRACE_CLASS_EQ_FIR      (19 << 24)
 #define TRACE_CLASS_EQ_IIR      (20 << 24)
+#define TRACE_CLASS_MARK	(21 << 24)
+#define TRACE_CLASS_PROFILE	(22 << 24)
+#define TRACE_CLASS_PERF	(23 << 24)
+
+/* class bit in the runtime level masks */
+#define TRACE_CLASS_BIT(__c)	(1 << ((__c) >> 24))
+
+/* runtime trace levels, each has a mask of enabled classes */
+#define TRACE_LEVEL_ERROR	0
+#define TRACE_LEVEL_NORMAL	1
+#define TRACE_LEVEL_VERBOSE	2
+#define TRACE_LEVELS		3
 
 /* move to config.h */
 #define TRACE	1
-#define TRACEV	0
+#define TRACEV	1
 #define TRACEE	1
 
-void _trace_event(uint32_t event);
+extern uint32_t trace_mask[TRACE_LEVELS];
+
+void _trace_event(uint32_t id, uint32_t argc, uint32_t a0, uint32_t a1,
+	uint32_t a2);
+void trace_set_mask(uint32_t level, uint32_t mask);
+void trace_flush(void);
 void trace_off(void);
 void trace_init(struct reef * reef);
 
 #if TRACE
 
+/* dictionary entry for this trace site, its address is the event ID */
+#define _trace_id(__c, __e, __n) \
+	({ \
+		static const struct trace_dict_entry __trace_site \
+			__attribute__((section(".trace_dict"), used)) = { \
+			.trace_class = __c, \
+			.code = __e, \
+			.line = __LINE__, \
+			.argc = __n, \
+			.file = __FILE__, \
+		}; \
+		(uint32_t)&__trace_site; \
+	})
+
+/* class is constant so the filter is a single load and branch */
+#define _trace_level(__c, __l, __e, __n, __a0, __a1, __a2) \
+	do { \
+		if (trace_mask[__l] & TRACE_CLASS_BIT(__c)) \
+			_trace_event(_trace_id(__c, __e, __n), __n, \
+				__a0, __a1, __a2); \
+	} while (0)
+
 #define trace_event(__c, __e) \
-	_trace_event(__c | (__e[0] << 16) | (__e[1] <<8) | __e[2])
+	_trace_level(__c, TRACE_LEVEL_NORMAL, __e, 0, 0, 0, 0)
 
-#define trace_value(x)	_trace_event(x)
+/* event with inline values */
+#define trace_event_value(__c, __e, __v) \
+	_trace_level(__c, TRACE_LEVEL_NORMAL, __e, 1, __v, 0, 0)
+#define trace_event_value2(__c, __e, __v0, __v1) \
+	_trace_level(__c, TRACE_LEVEL_NORMAL, __e, 2, __v0, __v1, 0)
+#define trace_event_value3(__c, __e, __v0, __v1, __v2) \
+	_trace_level(__c, TRACE_LEVEL_NORMAL, __e, 3, __v0, __v1, __v2)
+
+#define trace_value(x) \
+	_trace_event(_trace_id(0, "val", 1), 1, x, 0, 0)
 
 #define trace_point(x) platform_trace_point(x)
 
 /* verbose tracing */
 #if TRACEV
-#define tracev_event(__c, __e) trace_event(__c, __e)
-#define tracev_value(x)	_trace_event(x)
+#define tracev_event(__c, __e) \
+	_trace_level(__c, TRACE_LEVEL_VERBOSE, __e, 0, 0, 0, 0)
+#define tracev_value(x) \
+	do { \
+		if (trace_mask[TRACE_LEVEL_VERBOSE]) \
+			trace_value(x); \
+	} while (0)
 #else
 #define tracev_event(__c, __e)
 #define tracev_value(x)
@@ -117,15 +171,23 @@ void trace_init(struct reef * reef);
 
 /* error tracing */
 #if TRACEE
-#define trace_error(__c, __e) trace_event(__c, __e)
+#define trace_error(__c, __e) \
+	_trace_level(__c, TRACE_LEVEL_ERROR, __e, 0, 0, 0, 0)
+#define trace_error_value(__c, __e, __v) \
+	_trace_level(__c, TRACE_LEVEL_ERROR, __e, 1, __v, 0, 0)
 #else
 #define trace_error(__c, __e)
+#define trace_error_value(__c, __e, __v)
 #endif
 
 #else
 
 #define trace_event(x, e)
+#define trace_event_value(c, e, v)
+#define trace_event_value2(c, e, v0, v1)
+#define trace_event_value3(c, e, v0, v1, v2)
 #define trace_error(c, e)
+#define trace_error_value(c, e, v)
 #define trace_value(x)
 #define trace_point(x)
 #define tracev_event(__c, __e)
@@ -133,4 +195,29 @@ void trace_init(struct reef * reef);
 
 #endif
 
+/*
+ * Hot path latency markers, off until the host enables TRACE_CLASS_MARK at
+ * the normal level. The host timeline tool matches them by code.
+ */
+#define TRACE_MARK_DAI_DMA	"mDd"	/* DAI DMA complete, comp */
+#define TRACE_MARK_HOST_DMA	"mDh"	/* host DMA complete, comp */
+#define TRACE_MARK_TASK_QUEUE	"mTq"	/* task released, task ID, deadline */
+#define TRACE_MARK_TASK_RUN	"mTs"	/* task started, task ID, deadline */
+#define TRACE_MARK_COPY_BEGIN	"mCb"	/* comp_copy() begin, comp */
+#define TRACE_MARK_COPY_END	"mCe"	/* comp_copy() end, comp */
+#define TRACE_MARK_IPC_RX	"mIr"	/* IPC received, header */
+#define TRACE_MARK_IPC_REPLY	"mIp"	/* IPC command done, error */
+
+/* task ID of the IPC task, pipeline tasks use the pipeline ID */
+#define TRACE_MARK_TASK_IPC	0xffff
+
+/* pipeline ID in high 16 bits and component ID in low 16 bits */
+#define TRACE_MARK_COMP(__dev) \
+	(((__dev)->comp.pipeline_id << 16) | ((__dev)->comp.id & 0xffff))
+
+#define trace_mark(__e, __v) \
+	trace_event_value(TRACE_CLASS_MARK, __e, __v)
+#define trace_mark2(__e, __v0, __v1) \
+	trace_event_value2(TRACE_CLASS_MARK, __e, __v0, __v1)
+
 #endif
@@ -46,6 +46,7 @@ typedef struct {
 	uint32_t complete;
 	struct work work;
 	uint32_t timeout;
+	uint32_t error;
 } completion_t;
 
 void arch_wait_for_interrupt(int level);
@@ -79,11 +80,20 @@ static inline void wait_completed(completion_t *comp)
 	c->complete = 1;
 }
 
+/* wake the waiter with an error, e.g. the DMA transfer failed */
+static inline void wait_failed(completion_t *comp)
+{
+	volatile completion_t *c = (volatile completion_t *)comp;
+
+	c->error = 1;
+}
+
 static inline void wait_init(completion_t *comp)
 {
 	volatile completion_t *c = (volatile completion_t *)comp;
 
 	c->complete = 0;
+	c->error = 0;
 	work_init(&comp->work, _wait_cb, comp, WORK_ASYNC);
 }
 
@@ -118,6 +128,8 @@ static inline int wait_for_completion_timeout(completion_t *comp)
 			break;
 		if (c->timeout)
 			break;
+		if (c->error)
+			break;
 
 		wait_for_interrupt(0);
 	}
@@ -127,6 +139,10 @@ static inline int wait_for_completion_timeout(completion_t *comp)
 		/* no timeout so cancel work and return 0 */
 		work_cancel_default(&comp->work);
 		return 0;
+	} else if (c->error) {
+		/* failed, cancel work and return error */
+		work_cancel_default(&comp->work);
+		return -EIO;
 	} else {
 		/* timeout */
 		trace_value(c->timeout);
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * Stack and IRQ off watermarks.
+ */
+
+#ifndef __INCLUDE_WATERMARK__
+#define __INCLUDE_WATERMARK__
+
+#include <stdint.h>
+#include <arch/interrupt.h>
+
+/* move to config.h */
+#define WATERMARK	1
+
+/* longest section with IRQs globally disabled */
+struct irq_off_watermark {
+	uint32_t active;	/* section in progress */
+	uint32_t start;		/* CPU cycle count at section start */
+	uint32_t start_site;
+	uint32_t max;		/* longest section in CPU cycles */
+	uint32_t max_site;	/* code address of the longest section disable */
+};
+
+#if WATERMARK
+
+extern struct irq_off_watermark irq_off_wm;
+
+void _watermark_irq_off(void);
+void _watermark_irq_on(void);
+
+/* only the outermost disable and enable start and end a section */
+static inline void watermark_irq_off(uint32_t flags)
+{
+	if (!arch_interrupt_global_masked(flags))
+		_watermark_irq_off();
+}
+
+static inline void watermark_irq_on(uint32_t flags)
+{
+	if (!arch_interrupt_global_masked(flags) && irq_off_wm.active)
+		_watermark_irq_on();
+}
+
+void stack_paint(void);
+uint32_t stack_size(void);
+uint32_t stack_used(void);
+
+void watermark_reset(void);
+
+#else
+
+static inline void watermark_irq_off(uint32_t flags) {}
+static inline void watermark_irq_on(uint32_t flags) {}
+
+static inline void stack_paint(void) {}
+static inline uint32_t stack_size(void) { return 0; }
+static inline uint32_t stack_used(void) { return 0; }
+
+static inline void watermark_reset(void) {}
+
+#endif
+
+#endif
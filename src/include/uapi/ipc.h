@@ -64,12 +64,17 @@
 #define SOF_IPC_FW_READY			SOF_GLB_TYPE(0x7U)
 #define SOF_IPC_GLB_DAI_MSG			SOF_GLB_TYPE(0x8U)
 #define SOF_IPC_GLB_TRACE_MSG			SOF_GLB_TYPE(0x9U)
+#define SOF_IPC_GLB_RX_RING			SOF_GLB_TYPE(0xAU)
 
 /*
  * DSP Command Message Types
  */
 
 
+/* compound */
+#define SOF_IPC_COMPOUND_MAILBOX		SOF_CMD_TYPE(0x001)
+#define SOF_IPC_COMPOUND_DMA			SOF_CMD_TYPE(0x002)
+
 /* topology */
 #define SOF_IPC_TPLG_COMP_NEW			SOF_CMD_TYPE(0x001)
 #define SOF_IPC_TPLG_COMP_FREE			SOF_CMD_TYPE(0x002)
@@ -94,6 +99,7 @@
 #define SOF_IPC_COMP_GET_VALUE			SOF_CMD_TYPE(0x002)
 #define SOF_IPC_COMP_SET_DATA			SOF_CMD_TYPE(0x003)
 #define SOF_IPC_COMP_GET_DATA			SOF_CMD_TYPE(0x004)
+#define SOF_IPC_COMP_BULK			SOF_CMD_TYPE(0x005)
 
 
 /* DAI messages */
@@ -117,6 +123,13 @@
 /* trace and debug */
 #define SOF_IPC_TRACE_DMA_INIT			SOF_CMD_TYPE(0x001)
 #define SOF_IPC_TRACE_DMA_PARAMS		SOF_CMD_TYPE(0x002)
+#define SOF_IPC_TRACE_DMA_CHAN_STATS		SOF_CMD_TYPE(0x003)
+#define SOF_IPC_TRACE_IPC_STATS			SOF_CMD_TYPE(0x004)
+#define SOF_IPC_TRACE_LEVEL			SOF_CMD_TYPE(0x005)
+#define SOF_IPC_TRACE_PROFILE			SOF_CMD_TYPE(0x006)
+#define SOF_IPC_TRACE_WATERMARK			SOF_CMD_TYPE(0x007)
+#define SOF_IPC_TRACE_LOAD			SOF_CMD_TYPE(0x008)
+#define SOF_IPC_TRACE_XRUN			SOF_CMD_TYPE(0x009)
 
 /* Get message component id */
 #define SOF_IPC_MESSAGE_ID(x)			(x & 0xffff)
@@ -146,6 +159,41 @@ struct sof_ipc_reply {
 }  __attribute__((packed));
 
 
+/*
+ * Inbound command ring - SOF_IPC_GLB_RX_RING.
+ *
+ * The host mailbox is split into SOF_IPC_RX_RING_SLOTS slots that each start
+ * with a struct sof_ipc_rx_slot. The host writes a command after the slot
+ * header of the next FREE slot in ring order, sets the state to CMD and rings
+ * the doorbell with SOF_IPC_GLB_RX_RING. The DSP runs CMD slots in ring order,
+ * writes the reply into the same slot, sets the state to REPLY and signals
+ * DONE. The host reads each REPLY slot and sets it back to FREE.
+ *
+ * Doorbell BUSY is only held while no slot is FREE so the host can post new
+ * commands while the DSP is still running earlier ones. Hosts that don't
+ * use the ring send single commands at mailbox offset 0 as before.
+ *
+ * A reply is never larger than the slot space after the slot header. Control
+ * get replies are written over the command with the command size, so a
+ * control whose data doesn't fit must be sent as a single command. Compound
+ * and PM restore replies carry as many command status as fit. A command with
+ * hdr.size larger than the slot space is not run and gets a -E2BIG reply.
+ */
+
+#define SOF_IPC_RX_RING_SLOTS		4
+#define SOF_IPC_RX_SLOT_SIZE		256	/* 4 slots fit 1k mailbox */
+
+/* slot states */
+#define SOF_IPC_RX_SLOT_FREE		0	/* owned by host */
+#define SOF_IPC_RX_SLOT_CMD		1	/* owned by DSP */
+#define SOF_IPC_RX_SLOT_REPLY		2	/* owned by host */
+
+struct sof_ipc_rx_slot {
+	uint32_t state;			/* SOF_IPC_RX_SLOT_ */
+	uint32_t reserved;
+	/* command or reply follows */
+}  __attribute__((packed));
+
 /*
  * Compound commands - SOF_IPC_GLB_COMPOUND.
  *
@@ -153,13 +201,43 @@ struct sof_ipc_reply {
  * commands are split into blocks and each block has a header. This header
  * identifies the command type and the number of commands before the next
  * header.
+ *
+ * SOF_IPC_COMPOUND_MAILBOX - a struct sof_ipc_hdr is followed by the blocks
+ * in the mailbox, hdr.size covers all blocks.
+ * SOF_IPC_COMPOUND_DMA - blocks are in a physically contiguous host buffer
+ * described by struct sof_ipc_compound_dma and are read using host DMA.
+ *
+ * Commands are run in order and the first failure stops the sequence. The
+ * reply contains the status of each command run, commands that have their
+ * own reply types only return status when sent as part of a compound.
+ *
+ * The DSP may also send queued notifications of the same type to the host
+ * as one SOF_IPC_COMPOUND_MAILBOX message in the DSP mailbox.
  */
 
+/* max commands and payload bytes in a compound message */
+#define SOF_IPC_COMPOUND_MAX_CMDS	128
+#define SOF_IPC_COMPOUND_MAX_SIZE	0x4000
+
 struct sof_ipc_compound_hdr {
 	struct sof_ipc_hdr hdr;
 	uint32_t count;			/* count of 0 means end of compound sequence */
 }  __attribute__((packed));
 
+/* compound payload in host memory - SOF_IPC_COMPOUND_DMA */
+struct sof_ipc_compound_dma {
+	struct sof_ipc_hdr hdr;
+	uint32_t phy_addr;		/* physical address of blocks */
+	uint32_t size;			/* size in bytes of all blocks */
+}  __attribute__((packed));
+
+/* compound reply - status for each command run */
+struct sof_ipc_compound_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t count;			/* number of commands run */
+	int32_t status[0];		/* 0 or negative error number */
+}  __attribute__((packed));
+
 
 /*
  * DAI Configuration.
@@ -496,6 +574,25 @@ struct sof_ipc_ctrl_data {
 	};
 } __attribute__((packed));
 
+/* max controls in a bulk control message */
+#define SOF_IPC_CTRL_BULK_MAX	64
+
+/*
+ * Bulk control get/set - SOF_IPC_COMP_BULK.
+ *
+ * Followed by count sof_ipc_ctrl_data items packed back to back, each sized
+ * by its rhdr.hdr.size and using its type for get or set. All set items are
+ * applied between the same two pipeline periods. The reply is the message
+ * itself with the status of each item in its rhdr.error and get values
+ * filled in.
+ */
+struct sof_ipc_ctrl_bulk {
+	struct sof_ipc_reply rhdr;
+	uint32_t count;
+	uint32_t reserved;
+	/* followed by count struct sof_ipc_ctrl_data */
+} __attribute__((packed));
+
 
 /*
  * Component
@@ -722,6 +819,26 @@ struct sof_ipc_pm_ctx {
 	struct sof_ipc_pm_ctx_elem elems[];
 };
 
+/*
+ * Topology snapshot in the PM context buffer.
+ *
+ * SOF_IPC_PM_CTX_SIZE returns the snapshot size and SOF_IPC_PM_CTX_SAVE
+ * writes it to the host buffer, size is 0 if there is no snapshot. After
+ * resume SOF_IPC_PM_CTX_RESTORE with the same buffer and size rebuilds the
+ * graph and control values in the DSP, the reply is a struct
+ * sof_ipc_compound_reply. The snapshot holds the topology and control IPC
+ * messages as compound blocks ending with a block count of 0.
+ */
+#define SOF_IPC_PM_SNAP_MAGIC		0x50414e53	/* "SNAP" */
+#define SOF_IPC_PM_SNAP_MAX_SIZE	0x4000
+
+struct sof_ipc_pm_snap {
+	uint32_t magic;
+	uint32_t size;			/* bytes including this header */
+	uint32_t count;			/* number of IPC messages */
+	uint32_t reserved;
+}  __attribute__((packed));
+
 /*
  * Firmware boot and version
  */
@@ -811,4 +928,173 @@ struct sof_ipc_dma_trace_params {
 	struct sof_ipc_host_buffer buffer;
 }  __attribute__((packed));
 
+/* DMA channel statistics request - SOF_IPC_TRACE_DMA_CHAN_STATS */
+struct sof_ipc_dma_chan_stats {
+	struct sof_ipc_hdr hdr;
+	uint32_t dmac_id;
+	uint32_t channel;
+}  __attribute__((packed));
+
+/* DMA channel statistics reply - SOF_IPC_TRACE_DMA_CHAN_STATS */
+struct sof_ipc_dma_chan_stats_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t dmac_id;
+	uint32_t channel;
+	uint32_t priority;	/* 0 low, 1 normal, 2 high */
+	uint32_t state;
+	uint64_t bytes;
+	uint32_t irqs;
+	uint32_t errors;
+	uint32_t reload_last;	/* IRQ to reload latency in DSP timer ticks */
+	uint32_t reload_max;
+}  __attribute__((packed));
+
+/* runtime trace levels - SOF_IPC_TRACE_LEVEL */
+#define SOF_IPC_TRACE_LEVEL_ERROR	0
+#define SOF_IPC_TRACE_LEVEL_NORMAL	1
+#define SOF_IPC_TRACE_LEVEL_VERBOSE	2
+#define SOF_IPC_TRACE_LEVELS		3
+
+/* trace class masks, bit n enables trace class n - SOF_IPC_TRACE_LEVEL */
+struct sof_ipc_trace_level {
+	struct sof_ipc_hdr hdr;
+	uint32_t set;		/* bit n updates level n mask, 0 reads masks */
+	uint32_t class_mask[SOF_IPC_TRACE_LEVELS];
+}  __attribute__((packed));
+
+/* current trace class masks - SOF_IPC_TRACE_LEVEL */
+struct sof_ipc_trace_level_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t class_mask[SOF_IPC_TRACE_LEVELS];
+}  __attribute__((packed));
+
+/* sampling profiler control - SOF_IPC_TRACE_PROFILE */
+struct sof_ipc_trace_profile {
+	struct sof_ipc_hdr hdr;
+	uint32_t rate_hz;	/* samples per second, 0 stops the profiler */
+	uint32_t report_ms;	/* period of profile records in the DMA trace */
+}  __attribute__((packed));
+
+/* stack and IRQ off watermarks - SOF_IPC_TRACE_WATERMARK */
+struct sof_ipc_trace_watermark {
+	struct sof_ipc_hdr hdr;
+	uint32_t reset;		/* non zero restarts watermarks after reading */
+}  __attribute__((packed));
+
+struct sof_ipc_trace_watermark_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t stack_size;		/* bytes */
+	uint32_t stack_used;		/* deepest use in bytes */
+	uint32_t irq_off_cycles;	/* longest IRQ off section */
+	uint32_t irq_off_us;
+	uint32_t irq_off_site;		/* code address of section start */
+}  __attribute__((packed));
+
+/* DSP load - SOF_IPC_TRACE_LOAD */
+struct sof_ipc_trace_load {
+	struct sof_ipc_hdr hdr;
+	uint32_t reset_peak;	/* non zero resets peaks after reading */
+}  __attribute__((packed));
+
+#define SOF_IPC_LOAD_MAX_PIPES	8
+
+/* loads are in 0.1% of DSP time over the last window */
+struct sof_ipc_pipe_load {
+	uint32_t pipeline_id;
+	uint32_t load;
+	uint32_t peak;
+}  __attribute__((packed));
+
+struct sof_ipc_trace_load_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t window_ticks;	/* platform timer ticks in last window */
+	uint32_t load;		/* total DSP load */
+	uint32_t peak;
+	uint32_t num_pipes;
+	struct sof_ipc_pipe_load pipe[SOF_IPC_LOAD_MAX_PIPES];
+}  __attribute__((packed));
+
+/*
+ * XRUN post-mortem record - SOF_IPC_TRACE_XRUN
+ *
+ * Taken at the first XRUN after the host last read the record, reading the
+ * record re-arms it. Times are the low 32 bits of the DSP platform timer.
+ * The reply is sized to fit the reply space of an inbound ring slot.
+ */
+#define SOF_IPC_XRUN_MAX_BUFFERS	4
+#define SOF_IPC_XRUN_MAX_COMPS		4
+
+/* buffer fill levels in bytes available */
+struct sof_ipc_xrun_buffer {
+	uint32_t comp_id;
+	uint32_t size;
+	uint32_t avail;		/* at XRUN */
+	uint32_t min;		/* current window */
+	uint32_t max;
+	uint32_t last_min;	/* last complete window */
+	uint32_t last_max;
+}  __attribute__((packed));
+
+struct sof_ipc_xrun_comp {
+	uint32_t comp_id;
+	uint32_t type;		/* SOF_COMP_ */
+	uint32_t state;		/* COMP_STATE_ */
+}  __attribute__((packed));
+
+struct sof_ipc_trace_xrun_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t count;		/* XRUNs since last read, 0 if no record */
+	uint32_t pipeline_id;
+	uint32_t comp_id;	/* component that detected the XRUN */
+	int32_t xrun_size;	/* bytes, < 0 is underrun */
+	uint32_t direction;	/* SOF_IPC_STREAM_ */
+	uint32_t time;
+
+	/* pipeline task */
+	uint32_t task_state;	/* TASK_STATE_ */
+	uint32_t task_start;	/* last run start */
+	uint32_t task_ticks;	/* last run length */
+	uint32_t task_deadline;
+	uint32_t load;		/* last window in 0.1% of DSP time */
+	uint32_t peak;
+
+	/* last DAI DMA period completion, 0 if none */
+	uint32_t dma_time;
+	uint32_t dma_period_ticks;
+
+	uint32_t num_buffers;
+	uint32_t num_comps;
+	struct sof_ipc_xrun_buffer buffer[SOF_IPC_XRUN_MAX_BUFFERS];
+	struct sof_ipc_xrun_comp comp[SOF_IPC_XRUN_MAX_COMPS];
+}  __attribute__((packed));
+
+/* latency histogram bins, bin n counts latencies below 1024 << n ticks */
+#define SOF_IPC_STATS_BINS	10
+
+/* IPC statistics request - SOF_IPC_TRACE_IPC_STATS */
+struct sof_ipc_ipc_stats {
+	struct sof_ipc_hdr hdr;
+	uint32_t glb_type;	/* SOF_IPC_GLB_ class, 0 dumps all to trace */
+}  __attribute__((packed));
+
+struct sof_ipc_ipc_stats_reply {
+	struct sof_ipc_reply rhdr;
+	uint32_t glb_type;
+	uint32_t clock_hz;	/* latency tick frequency */
+
+	/* host commands of this class */
+	uint32_t count;
+	uint32_t errors;
+	uint32_t queue_max;	/* doorbell to handler in ticks */
+	uint32_t exec_max;	/* handler run time in ticks */
+	uint32_t hist[SOF_IPC_STATS_BINS];	/* doorbell to reply */
+
+	/* DSP notifications */
+	uint32_t tx_count;
+	uint32_t tx_coalesced;
+	uint32_t tx_dropped;
+	uint32_t tx_depth_max;	/* queue high water mark */
+	uint32_t tx_ack_max;	/* send to host DONE in ticks */
+}  __attribute__((packed));
+
 #endif
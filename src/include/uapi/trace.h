@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ */
+
+#ifndef __INCLUDE_UAPI_TRACE_H__
+#define __INCLUDE_UAPI_TRACE_H__
+
+/*
+ * Compact mailbox trace format.
+ *
+ * The trace ring is split into blocks, records never cross a block and each
+ * block starts with a sync record. Records are 32 bit words, a header word
+ * followed by the event arguments :-
+ *
+ *	0xIIIITTTT where
+ * I is the event ID (16 bits)
+ * T is the low 16 bits of the DSP timer
+ *
+ * The event ID is the offset in words of the event trace_dict_entry in the
+ * .trace_dict section of the firmware ELF, the entry gives the argument
+ * count. This section is not loaded and is used by the host as the event
+ * dictionary.
+ *
+ * A sync record has one argument, the full 32 bit timestamp. The firmware
+ * adds a sync record whenever the timestamp could not be unwrapped from the
+ * previous record. An ID of 0 marks the end of the records in a block.
+ */
+
+#define TRACE_BLOCK_SIZE	128
+#define TRACE_MAX_ARGS		3
+
+#define TRACE_ID_END		0
+#define TRACE_ID_SYNC		0xffff
+
+#define TRACE_REC_HDR(id, ts)	(((id) << 16) | ((ts) & 0xffff))
+#define TRACE_REC_ID(hdr)	((hdr) >> 16)
+#define TRACE_REC_TS(hdr)	((hdr) & 0xffff)
+
+/* max DSP timer ticks between records before a sync record is needed */
+#define TRACE_SYNC_TICKS	0x8000
+
+/* trace site, file is the null terminated source file name */
+struct trace_dict_entry {
+	uint32_t trace_class;	/* TRACE_CLASS_, 0 for trace_value() */
+	char code[4];		/* 3 character event code */
+	uint32_t line;
+	uint32_t argc;
+	char file[];
+}  __attribute__((packed, aligned(4)));
+
+/*
+ * Sampling profiler records, sent in the DMA trace stream.
+ *
+ * Each record is a trace_profile_hdr followed by count entries. An entry
+ * counts the samples taken at pc while the context ctx was running, ctx is
+ * the TRACE_MARK_COMP() value of the component being copied or
+ * TRACE_PROFILE_CTX_NONE. A report is one or more records, the last record
+ * of a report has the report sample count and the samples that did not fit
+ * in the firmware table, earlier records have 0 in these fields.
+ */
+
+#define TRACE_PROFILE_MAGIC	0x464f5250	/* "PROF" */
+#define TRACE_PROFILE_CTX_NONE	0xffffffff
+
+struct trace_profile_hdr {
+	uint32_t magic;
+	uint32_t count;		/* entries following this header */
+	uint32_t samples;	/* samples in the report, last record only */
+	uint32_t dropped;
+}  __attribute__((packed));
+
+struct trace_profile_entry {
+	uint32_t pc;
+	uint32_t ctx;
+	uint32_t count;
+}  __attribute__((packed));
+
+#endif
@@ -40,6 +40,7 @@
 #include <reef/work.h>
 #include <reef/trace.h>
 #include <reef/schedule.h>
+#include <reef/watermark.h>
 #include <platform/platform.h>
 
 /* main firmware context */
@@ -49,6 +50,9 @@ int main(int argc, char *argv[])
 {
 	int err;
 
+	/* paint stack before it's used for stack watermark */
+	stack_paint();
+
 	trace_point(TRACE_BOOT_START);
 
 	/* setup context */
@@ -47,6 +47,7 @@
 #include <platform/shim.h>
 #include <platform/dma.h>
 #include <platform/platform.h>
+#include <platform/timer.h>
 #include <reef/audio/component.h>
 #include <reef/audio/pipeline.h>
 #include <uapi/ipc.h>
@@ -74,11 +75,18 @@ static void do_notify(void)
 	if (msg->cb)
 		msg->cb(msg->cb_data, msg->rx_data);
 
+	ipc_stats_tx_ack(_ipc);
+
 	list_item_append(&msg->list, &_ipc->empty_list);
+	_ipc->dsp_msg = NULL;
 
 out:
 	spin_unlock_irq(&_ipc->lock, flags);
 
+	/* host can take the next notification now */
+	if (_ipc->dsp_pending)
+		ipc_schedule_process(_ipc);
+
 	/* clear DONE bit - tell Host we have completed */
 	shim_write(SHIM_IPCDH, shim_read(SHIM_IPCDH) & ~SHIM_IPCDH_DONE);
 
@@ -86,10 +94,65 @@ out:
 	shim_write(SHIM_IMRD, shim_read(SHIM_IMRD) & ~SHIM_IMRD_DONE);
 }
 
+/* clear BUSY bit and set DONE bit if requested - accept new messages */
+static void ipc_release_busy(uint32_t done)
+{
+	uint32_t ipcxh;
+
+	ipcxh = shim_read(SHIM_IPCXH);
+	ipcxh &= ~SHIM_IPCXH_BUSY;
+	if (done)
+		ipcxh |= SHIM_IPCXH_DONE;
+	shim_write(SHIM_IPCXH, ipcxh);
+
+	/* unmask busy interrupt */
+	shim_write(SHIM_IMRD, shim_read(SHIM_IMRD) & ~SHIM_IMRD_BUSY);
+}
+
+/* does the inbound ring have a slot the host can post to ? */
+static int ipc_rx_ring_space(void)
+{
+	struct sof_ipc_rx_slot slot;
+	int i;
+
+	for (i = 0; i < SOF_IPC_RX_RING_SLOTS; i++) {
+		mailbox_hostbox_read(&slot, i * SOF_IPC_RX_SLOT_SIZE,
+			sizeof(slot));
+		if (slot.state == SOF_IPC_RX_SLOT_FREE)
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Time stamp ring slots posted since the last doorbell, so each command's
+ * queue latency starts at the doorbell that posted it. Called from the IPC
+ * IRQ or with ipc->lock held.
+ */
+static void ipc_rx_ring_stamp(uint64_t time)
+{
+	struct sof_ipc_rx_slot slot;
+	uint32_t i;
+
+	while (_ipc->rx_stamped < SOF_IPC_RX_RING_SLOTS) {
+		i = (_ipc->rx_next + _ipc->rx_stamped) % SOF_IPC_RX_RING_SLOTS;
+		mailbox_hostbox_read(&slot, i * SOF_IPC_RX_SLOT_SIZE,
+			sizeof(slot));
+		if (slot.state != SOF_IPC_RX_SLOT_CMD)
+			break;
+
+		_ipc->rx_time[i] = time;
+		_ipc->rx_stamped++;
+	}
+}
+
 /* test code to check working IRQ */
 static void irq_handler(void *arg)
 {
 	uint32_t isr;
+	uint32_t msg;
+	uint64_t time;
 
 	tracev_ipc("IRQ");
 
@@ -110,28 +173,51 @@ static void irq_handler(void *arg)
 		shim_write(SHIM_IMRD, shim_read(SHIM_IMRD) | SHIM_IMRD_BUSY);
 		interrupt_clear(PLATFORM_IPC_INTERUPT);
 
-		/* TODO: place message in Q and process later */
-		/* It's not Q ATM, may overwrite */
-		if (_ipc->host_pending)
-			trace_ipc_error("Pen");
-		_ipc->host_msg = shim_read(SHIM_IPCXL);
-		_ipc->host_pending = 1;
+		msg = shim_read(SHIM_IPCXL);
+		time = platform_timer_get(platform_timer);
+		trace_mark(TRACE_MARK_IPC_RX, msg);
+
+		/* ring commands stay in their slots until run */
+		if (msg == SOF_IPC_GLB_RX_RING) {
+			ipc_rx_ring_stamp(time);
+			_ipc->rx_pending = 1;
+
+			/* busy is only held while the ring is full */
+			if (ipc_rx_ring_space())
+				ipc_release_busy(0);
+		} else {
+			/* single command uses the mailbox until it's run */
+			if (_ipc->host_pending)
+				trace_ipc_error("Pen");
+			_ipc->host_msg = msg;
+			_ipc->host_rx_time = time;
+			_ipc->host_pending = 1;
+		}
+
+		ipc_schedule_process(_ipc);
 	}
 }
 
-void ipc_platform_do_cmd(struct ipc *ipc)
+/* run command at current hostbox offset and write reply after it */
+static void ipc_do_cmd(struct ipc *ipc)
 {
-	struct intel_ipc_data *iipc = ipc_get_drvdata(ipc);
 	struct sof_ipc_reply reply;
-	uint32_t ipcxh;
+	struct sof_ipc_hdr hdr;
 	int32_t err;
 
-	tracev_ipc("Cmd");
-
-	/* perform command and return any error */
-	err = ipc_cmd();
+	/* replies are written over the command so it must fit the space */
+	mailbox_hostbox_read(&hdr, ipc->host_offset, sizeof(hdr));
+	if (hdr.size > ipc->host_size) {
+		trace_ipc_error("eCz");
+		trace_value(hdr.size);
+		err = -E2BIG;
+	} else {
+		/* perform command and return any error */
+		err = ipc_cmd();
+	}
+	trace_mark(TRACE_MARK_IPC_REPLY, err);
 	if (err > 0) {
-		goto done; /* reply created and copied by cmd() */
+		return; /* reply created and copied by cmd() */
 	} else if (err < 0) {
 		/* send std error reply */
 		reply.error = err;
@@ -143,35 +229,167 @@ void ipc_platform_do_cmd(struct ipc *ipc)
 	/* send std error/ok reply */
 	reply.hdr.cmd = SOF_IPC_GLB_REPLY;
 	reply.hdr.size = sizeof(reply);
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
+	mailbox_hostbox_write(ipc->host_offset, &reply, sizeof(reply));
+}
 
-done:
-	ipc->host_pending = 0;
+/*
+ * Run each ring slot owned by the DSP in ring order. Returns 1 if a blocking
+ * command was left for the idle loop.
+ */
+static int ipc_do_ring(struct ipc *ipc)
+{
+	struct sof_ipc_rx_slot slot;
+	uint32_t offset, flags;
+	int deferred = 0;
+
+	/* kicks after this are picked up by the next pass */
+	ipc->rx_pending = 0;
+
+	while (1) {
+		offset = ipc->rx_next * SOF_IPC_RX_SLOT_SIZE;
+		mailbox_hostbox_read(&slot, offset, sizeof(slot));
+		if (slot.state != SOF_IPC_RX_SLOT_CMD)
+			break;
+
+		/* blocking command and the slots after it run from idle */
+		ipc->host_offset = offset + sizeof(slot);
+		ipc->host_size = SOF_IPC_RX_SLOT_SIZE - sizeof(slot);
+		if (ipc_cmd_blocking()) {
+			ipc->rx_pending = 1;
+			ipc->idle_pending = 1;
+			deferred = 1;
+			break;
+		}
 
-	/* clear BUSY bit and set DONE bit - accept new messages */
-	ipcxh = shim_read(SHIM_IPCXH);
-	ipcxh &= ~SHIM_IPCXH_BUSY;
-	ipcxh |= SHIM_IPCXH_DONE;
-	shim_write(SHIM_IPCXH, ipcxh);
+		/* slot posted without a doorbell yet is timed from now */
+		spin_lock_irq(&ipc->lock, flags);
+		ipc_rx_ring_stamp(platform_timer_get(platform_timer));
+		ipc->host_rx_time = ipc->rx_time[ipc->rx_next];
+		spin_unlock_irq(&ipc->lock, flags);
 
-	/* unmask busy interrupt */
-	shim_write(SHIM_IMRD, shim_read(SHIM_IMRD) & ~SHIM_IMRD_BUSY);
+		ipc_do_cmd(ipc);
+
+		/* hand slot and reply back to host */
+		slot.state = SOF_IPC_RX_SLOT_REPLY;
+		mailbox_hostbox_write(offset, &slot, sizeof(slot));
+		spin_lock_irq(&ipc->lock, flags);
+		ipc->rx_next = (ipc->rx_next + 1) % SOF_IPC_RX_RING_SLOTS;
+		ipc->rx_stamped--;
+		spin_unlock_irq(&ipc->lock, flags);
+
+		/* reply is ready and ring is no longer full */
+		ipc_release_busy(1);
+	}
+
+	ipc->host_offset = 0;
+	ipc->host_size = MAILBOX_HOSTBOX_SIZE;
+	return deferred;
+}
+
+void ipc_platform_do_cmd(struct ipc *ipc)
+{
+	struct intel_ipc_data *iipc = ipc_get_drvdata(ipc);
+	int deferred = 0;
 
-	// TODO: signal audio work to enter D3 in normal context
-	/* are we about to enter D3 ? */
+	tracev_ipc("Cmd");
+
+	if (ipc->rx_pending)
+		deferred = ipc_do_ring(ipc);
+
+	/* single command waits behind a ring command left for idle */
+	if (ipc->host_pending && !deferred) {
+		if (ipc_cmd_blocking()) {
+			ipc->idle_pending = 1;
+		} else {
+			ipc_do_cmd(ipc);
+			ipc->host_pending = 0;
+			ipc_release_busy(1);
+		}
+	}
+
+	/* are we about to enter D3 ? - only from the idle loop */
 	if (iipc->pm_prepare_D3) {
-		while (1) {
-			trace_ipc("pme");
-			wait_for_interrupt(0);
+		if (interrupt_get_level() != 0) {
+			ipc->idle_pending = 1;
+		} else {
+			while (1) {
+				trace_ipc("pme");
+				wait_for_interrupt(0);
+			}
 		}
 	}
 
 	tracev_ipc("CmD");
 }
 
+/*
+ * Send queued messages of the same type together as one compound message
+ * when there are more than one of them. Locks held by caller.
+ */
+static uint32_t ipc_msg_batch(struct ipc *ipc, struct ipc_msg *msg)
+{
+	struct sof_ipc_compound_hdr block;
+	struct sof_ipc_hdr hdr;
+	struct ipc_msg *next;
+	struct list_item *plist, *tlist;
+	uint32_t offset = sizeof(hdr) + sizeof(block);
+	uint32_t count = 1;
+
+	if (!(msg->flags & IPC_MSG_BATCH))
+		return msg->header;
+
+	/* copy each following message of same type after the first */
+	list_for_item_safe(plist, tlist, &ipc->msg_list) {
+		next = container_of(plist, struct ipc_msg, list);
+		if (next->header != msg->header ||
+			next->tx_size != msg->tx_size ||
+			!(next->flags & IPC_MSG_BATCH))
+			break;
+		if (offset + msg->tx_size * (count + 1) + sizeof(block) >
+			MAILBOX_DSPBOX_SIZE)
+			break;
+
+		mailbox_dspbox_write(offset + msg->tx_size * count,
+			next->tx_data, next->tx_size);
+		list_item_del(&next->list);
+		list_item_append(&next->list, &ipc->empty_list);
+		ipc->stats.tx_depth--;
+		ipc_stats_tx_sent(ipc, 1);
+		count++;
+	}
+
+	/* single message is sent as is */
+	if (count == 1) {
+		mailbox_dspbox_write(0, msg->tx_data, msg->tx_size);
+		return msg->header;
+	}
+
+	mailbox_dspbox_write(offset, msg->tx_data, msg->tx_size);
+	offset += msg->tx_size * count;
+
+	/* block header and end of sequence */
+	block.hdr.cmd = msg->header;
+	block.hdr.size = sizeof(block) + msg->tx_size * count;
+	block.count = count;
+	mailbox_dspbox_write(sizeof(hdr), &block, sizeof(block));
+
+	block.hdr.size = sizeof(block);
+	block.count = 0;
+	mailbox_dspbox_write(offset, &block, sizeof(block));
+	offset += sizeof(block);
+
+	hdr.cmd = SOF_IPC_GLB_COMPOUND | SOF_IPC_COMPOUND_MAILBOX;
+	hdr.size = offset;
+	mailbox_dspbox_write(0, &hdr, sizeof(hdr));
+
+	tracev_ipc("MsB");
+	return hdr.cmd;
+}
+
 void ipc_platform_send_msg(struct ipc *ipc)
 {
 	struct ipc_msg *msg;
+	uint32_t header;
 	uint32_t flags;
 
 	spin_lock_irq(&ipc->lock, flags);
@@ -186,21 +404,47 @@ void ipc_platform_send_msg(struct ipc *ipc)
 	if (shim_read(SHIM_IPCDH) & (SHIM_IPCDH_BUSY | SHIM_IPCDH_DONE))
 		goto out;
 
-	/* now send the message */
+	/* now send the message and any that can go with it */
 	msg = list_first_item(&ipc->msg_list, struct ipc_msg, list);
-	mailbox_dspbox_write(0, msg->tx_data, msg->tx_size);
 	list_item_del(&msg->list);
+	ipc->stats.tx_depth--;
+	ipc_stats_tx_sent(ipc, 1);
+	header = ipc_msg_batch(ipc, msg);
 	ipc->dsp_msg = msg;
 	tracev_ipc("Msg");
 
 	/* now interrupt host to tell it we have message sent */
-	shim_write(SHIM_IPCDL, msg->header);
+	shim_write(SHIM_IPCDL, header);
 	shim_write(SHIM_IPCDH, SHIM_IPCDH_BUSY);
 
 out:
 	spin_unlock_irq(&ipc->lock, flags);
 }
 
+/*
+ * Write message straight from the caller data when nothing is queued and
+ * the host has acked the last message. Locks held by caller.
+ */
+int ipc_platform_send_direct(struct ipc *ipc, struct ipc_msg *msg,
+	void *tx_data)
+{
+	if (!list_is_empty(&ipc->msg_list) || ipc->dsp_msg != NULL)
+		return -EBUSY;
+
+	if (shim_read(SHIM_IPCDH) & (SHIM_IPCDH_BUSY | SHIM_IPCDH_DONE))
+		return -EBUSY;
+
+	mailbox_dspbox_write(0, tx_data, msg->tx_size);
+	ipc->dsp_msg = msg;
+	ipc_stats_tx_sent(ipc, 1);
+	tracev_ipc("MsD");
+
+	/* now interrupt host to tell it we have message sent */
+	shim_write(SHIM_IPCDL, msg->header);
+	shim_write(SHIM_IPCDH, SHIM_IPCDH_BUSY);
+	return 0;
+}
+
 int platform_ipc_init(struct ipc *ipc)
 {
 	struct intel_ipc_data *iipc;
@@ -213,6 +457,10 @@ int platform_ipc_init(struct ipc *ipc)
 	iipc = rzalloc(RZONE_SYS, RFLAGS_NONE, sizeof(struct intel_ipc_data));
 	ipc_set_drvdata(_ipc, iipc);
 	_ipc->dsp_msg = NULL;
+	_ipc->host_offset = 0;
+	_ipc->host_size = MAILBOX_HOSTBOX_SIZE;
+	_ipc->rx_next = 0;
+	_ipc->rx_stamped = 0;
 	list_init(&ipc->empty_list);
 	list_init(&ipc->msg_list);
 	spinlock_init(&ipc->lock);
@@ -64,12 +64,31 @@ static struct dma_sg_elem *sg_get_elem_at(struct dma_sg_config *host_sg,
 	return NULL;
 }
 
+/* bytes to copy in one DMA, host elems may span many pages */
+static inline int32_t sg_chunk_size(struct dma_sg_elem *host_sg_elem,
+	int32_t offset, int32_t size)
+{
+	int32_t chunk = host_sg_elem->size - offset;
+
+	if (chunk > HOST_PAGE_SIZE)
+		chunk = HOST_PAGE_SIZE;
+	if (chunk > size)
+		chunk = size;
+	return chunk;
+}
+
 static void dma_complete(void *data, uint32_t type, struct dma_sg_elem *next)
 {
 	completion_t *comp = (completion_t *)data;
 
 	if (type == DMA_IRQ_TYPE_LLIST)
 		wait_completed(comp);
+
+	/* fail the copy, don't restart the channel */
+	if (type == DMA_IRQ_TYPE_ERROR) {
+		next->size = DMA_RELOAD_END;
+		wait_failed(comp);
+	}
 }
 
 int dma_copy_to_host(struct dma_sg_config *host_sg, int32_t host_offset,
@@ -85,7 +104,7 @@ int dma_copy_to_host(struct dma_sg_config *host_sg, int32_t host_offset,
 		return -ENODEV;
 
 	/* get DMA channel from DMAC0 */
-	chan = dma_channel_get(dma);
+	chan = dma_channel_get(dma, DMA_PRIO_LOW);
 	if (chan < 0) {
 		//trace_ipc_error("ePC");
 		return chan;
@@ -107,7 +126,7 @@ int dma_copy_to_host(struct dma_sg_config *host_sg, int32_t host_offset,
 	/* configure local DMA elem */
 	local_sg_elem.dest = host_sg_elem->dest + offset;
 	local_sg_elem.src = (uint32_t)local_ptr;
-	local_sg_elem.size = HOST_PAGE_SIZE - offset;
+	local_sg_elem.size = sg_chunk_size(host_sg_elem, offset, size);
 	list_item_prepend(&local_sg_elem.list, &config.elem_list);
 
 	dma_set_cb(dma, chan, DMA_IRQ_TYPE_LLIST, dma_complete, &complete);
@@ -131,19 +150,18 @@ int dma_copy_to_host(struct dma_sg_config *host_sg, int32_t host_offset,
 		/* update offset and bytes remaining */
 		size -= local_sg_elem.size;
 		host_offset += local_sg_elem.size;
-
-		/* next dest host address is in next host elem */
-		host_sg_elem = list_next_item(host_sg_elem, list);
-		local_sg_elem.dest = host_sg_elem->dest;
+		offset += local_sg_elem.size;
 
 		/* local address is continuous */
-		local_sg_elem.src = (uint32_t)local_ptr + local_sg_elem.size;
+		local_sg_elem.src += local_sg_elem.size;
 
-		/* do we have less than 1 PAGE to copy ? */
-		if (size >= HOST_PAGE_SIZE)
-			local_sg_elem.size = HOST_PAGE_SIZE;
-		else
-			local_sg_elem.size = size;
+		/* next dest host address is in next host elem */
+		if (size > 0 && offset == host_sg_elem->size) {
+			host_sg_elem = list_next_item(host_sg_elem, list);
+			offset = 0;
+		}
+		local_sg_elem.dest = host_sg_elem->dest + offset;
+		local_sg_elem.size = sg_chunk_size(host_sg_elem, offset, size);
 	}
 
 	/* new host offset in SG buffer */
@@ -151,6 +169,46 @@ int dma_copy_to_host(struct dma_sg_config *host_sg, int32_t host_offset,
 	return host_offset;
 }
 
+int dma_copy_to_host_nowait(struct dma *dma, int chan,
+	struct dma_sg_config *host_sg, int32_t host_offset, void *local_ptr,
+	int32_t size)
+{
+	struct dma_sg_config config;
+	struct dma_sg_elem *host_sg_elem, local_sg_elem;
+	int32_t err, offset = host_offset;
+
+	if (size <= 0)
+		return -EINVAL;
+
+	/* find host element with host_offset */
+	host_sg_elem = sg_get_elem_at(host_sg, &offset);
+	if (host_sg_elem == NULL)
+		return -EINVAL;
+
+	/* set up DMA configuration, lli are built by dma_set_config() */
+	config.direction = DMA_DIR_LMEM_TO_HMEM;
+	config.src_width = sizeof(uint32_t);
+	config.dest_width = sizeof(uint32_t);
+	config.cyclic = 0;
+	list_init(&config.elem_list);
+
+	/* configure local DMA elem */
+	local_sg_elem.dest = host_sg_elem->dest + offset;
+	local_sg_elem.src = (uint32_t)local_ptr;
+	local_sg_elem.size = sg_chunk_size(host_sg_elem, offset, size);
+	list_item_prepend(&local_sg_elem.list, &config.elem_list);
+
+	err = dma_set_config(dma, chan, &config);
+	if (err < 0)
+		return err;
+
+	err = dma_start(dma, chan);
+	if (err < 0)
+		return err;
+
+	return local_sg_elem.size;
+}
+
 int dma_copy_from_host(struct dma_sg_config *host_sg, int32_t host_offset,
 	void *local_ptr, int32_t size)
 {
@@ -164,7 +222,7 @@ int dma_copy_from_host(struct dma_sg_config *host_sg, int32_t host_offset,
 		return -ENODEV;
 
 	/* get DMA channel from DMAC0 */
-	chan = dma_channel_get(dma);
+	chan = dma_channel_get(dma, DMA_PRIO_LOW);
 	if (chan < 0) {
 		//trace_ipc_error("ePC");
 		return chan;
@@ -186,7 +244,7 @@ int dma_copy_from_host(struct dma_sg_config *host_sg, int32_t host_offset,
 	/* configure local DMA elem */
 	local_sg_elem.dest = (uint32_t)local_ptr;
 	local_sg_elem.src = host_sg_elem->src + offset;
-	local_sg_elem.size = HOST_PAGE_SIZE - offset;
+	local_sg_elem.size = sg_chunk_size(host_sg_elem, offset, size);
 	list_item_prepend(&local_sg_elem.list, &config.elem_list);
 
 	dma_set_cb(dma, chan, DMA_IRQ_TYPE_LLIST, dma_complete, &complete);
@@ -210,19 +268,18 @@ int dma_copy_from_host(struct dma_sg_config *host_sg, int32_t host_offset,
 		/* update offset and bytes remaining */
 		size -= local_sg_elem.size;
 		host_offset += local_sg_elem.size;
-
-		/* next dest host address is in next host elem */
-		host_sg_elem = list_next_item(host_sg_elem, list);
-		local_sg_elem.src = host_sg_elem->src;
+		offset += local_sg_elem.size;
 
 		/* local address is continuous */
-		local_sg_elem.dest = (uint32_t)local_ptr + local_sg_elem.size;
+		local_sg_elem.dest += local_sg_elem.size;
 
-		/* do we have less than 1 PAGE to copy ? */
-		if (size >= HOST_PAGE_SIZE)
-			local_sg_elem.size = HOST_PAGE_SIZE;
-		else
-			local_sg_elem.size = size;
+		/* next source host address is in next host elem */
+		if (size > 0 && offset == host_sg_elem->size) {
+			host_sg_elem = list_next_item(host_sg_elem, list);
+			offset = 0;
+		}
+		local_sg_elem.src = host_sg_elem->src + offset;
+		local_sg_elem.size = sg_chunk_size(host_sg_elem, offset, size);
 	}
 
 	/* new host offset in SG buffer */
@@ -47,6 +47,12 @@
 #include <reef/wait.h>
 #include <reef/trace.h>
 #include <reef/ssp.h>
+#include <reef/clock.h>
+#include <reef/profile.h>
+#include <reef/watermark.h>
+#include <reef/load.h>
+#include <platform/clk.h>
+#include <platform/platform.h>
 #include <platform/interrupt.h>
 #include <platform/mailbox.h>
 #include <platform/shim.h>
@@ -64,12 +70,57 @@
 /* IPC context - shared with platform IPC driver */
 struct ipc *_ipc;
 
+/* current command in the host mailbox, pinned until the reply is sent */
+static inline void *ipc_hostbox_cmd(void)
+{
+	return (void *)(MAILBOX_HOSTBOX_BASE + _ipc->host_offset);
+}
+
+/*
+ * Write the reply for the current command, it must fit in the mailbox space
+ * of the command so ring slots owned by the host are never touched. The
+ * reply may have been built in place over the pinned command. Returns 1 so
+ * handlers can return it as "reply written".
+ */
+static inline int ipc_hostbox_reply(void *data, uint32_t size)
+{
+	if (size > _ipc->host_size) {
+		trace_ipc_error("eRs");
+		trace_value(size);
+		return -ENOSPC;
+	}
+
+	if (data == ipc_hostbox_cmd()) {
+		dcache_writeback_region(data, size);
+	} else {
+		mailbox_hostbox_write(_ipc->host_offset, data, size);
+	}
+	return 1;
+}
+
 static inline struct sof_ipc_hdr *mailbox_validate(void)
 {
 	struct sof_ipc_hdr *hdr = _ipc->comp_data;
+	struct sof_ipc_hdr *box;
 
 	/* read component values from the inbox */
-	mailbox_hostbox_read(hdr, 0, sizeof(*hdr));
+	mailbox_hostbox_read(hdr, _ipc->host_offset, sizeof(*hdr));
+
+	/* compound payloads are larger and read by their handler */
+	if ((hdr->cmd & SOF_GLB_TYPE_MASK) == SOF_IPC_GLB_COMPOUND)
+		return hdr;
+
+	/* control payloads are parsed in place without a copy */
+	if ((hdr->cmd & SOF_GLB_TYPE_MASK) == SOF_IPC_GLB_COMP_MSG) {
+		if (hdr->size < sizeof(*hdr) || hdr->size > _ipc->host_size) {
+			trace_ipc_error("ebc");
+			return NULL;
+		}
+
+		box = ipc_hostbox_cmd();
+		dcache_invalidate_region(box, hdr->size);
+		return box;
+	}
 
 	/* validate component header */
 	if (hdr->size > SOF_IPC_MSG_MAX_SIZE) {
@@ -78,7 +129,8 @@ static inline struct sof_ipc_hdr *mailbox_validate(void)
 	}
 
 	/* read rest of component data */
-	mailbox_hostbox_read(hdr + 1, sizeof(*hdr), hdr->size - sizeof(*hdr));
+	mailbox_hostbox_read(hdr + 1, _ipc->host_offset + sizeof(*hdr),
+		hdr->size - sizeof(*hdr));
 	return hdr;
 }
 
@@ -88,26 +140,32 @@ static void dma_complete(void *data, uint32_t type, struct dma_sg_elem *next)
 
 	if (type == DMA_IRQ_TYPE_LLIST)
 		wait_completed(&iipc->complete);
+
+	/* fail the copy, don't restart the channel */
+	if (type == DMA_IRQ_TYPE_ERROR) {
+		next->size = DMA_RELOAD_END;
+		wait_failed(&iipc->complete);
+	}
 }
 
 /*
- * Copy the audio buffer page tables from the host to the DSP max of 4K.
+ * Start copying a physically contiguous host buffer to the DSP using DMAC0.
+ * Returns the channel, the caller can do other work before waiting.
  */
-static int get_page_descriptors(struct intel_ipc_data *iipc,
-	struct sof_ipc_host_buffer *ring)
+static int ipc_host_dma_start(struct intel_ipc_data *iipc, void *dest,
+	uint32_t phy_addr, uint32_t size)
 {
 	struct dma_sg_config config;
 	struct dma_sg_elem elem;
-	struct dma *dma;
-	int chan, ret = 0;
+	struct dma *dma = iipc->dmac0;
+	int chan, ret;
 
 	/* get DMA channel from DMAC0 */
-	chan = dma_channel_get(iipc->dmac0);
+	chan = dma_channel_get(dma, DMA_PRIO_LOW);
 	if (chan < 0) {
 		trace_ipc_error("ePC");
 		return chan;
 	}
-	dma = iipc->dmac0;
 
 	/* set up DMA configuration */
 	config.direction = DMA_DIR_HMEM_TO_LMEM;
@@ -117,18 +175,16 @@ static int get_page_descriptors(struct intel_ipc_data *iipc,
 	list_init(&config.elem_list);
 
 	/* set up DMA desciptor */
-	elem.dest = (uint32_t)iipc->page_table;
-	elem.src = ring->phy_addr;
-
-	/* source buffer size is always PAGE_SIZE bytes */
-	/* 20 bits for each page, round up to 32 */
-	elem.size = (ring->pages * 5 * 16 + 31) / 32;
+	elem.dest = (uint32_t)dest;
+	elem.src = phy_addr;
+	elem.size = size;
 	list_item_prepend(&elem.list, &config.elem_list);
 
 	ret = dma_set_config(dma, chan, &config);
 	if (ret < 0) {
 		trace_ipc_error("ePs");
-		goto out;
+		dma_channel_put(dma, chan);
+		return ret;
 	}
 
 	/* set up callback */
@@ -136,67 +192,199 @@ static int get_page_descriptors(struct intel_ipc_data *iipc,
 
 	wait_init(&iipc->complete);
 
-	/* start the copy of page table to DSP */
+	/* start the copy to DSP */
 	dma_start(dma, chan);
+	return chan;
+}
+
+/* wait for copy started by ipc_host_dma_start() and release the channel */
+static int ipc_host_dma_wait(struct intel_ipc_data *iipc, int chan,
+	void *dest, uint32_t size)
+{
+	int ret;
 
 	/* wait for DMA to complete */
 	iipc->complete.timeout = PLATFORM_HOST_DMA_TIMEOUT;
 	ret = wait_for_completion_timeout(&iipc->complete);
 
-	/* compressed page tables now in buffer at _ipc->page_table */
-out:
-	dma_channel_put(dma, chan);
+	dcache_invalidate_region(dest, size);
+
+	dma_channel_put(iipc->dmac0, chan);
 	return ret;
 }
 
+/*
+ * Copy a physically contiguous host buffer to the DSP using DMAC0.
+ */
+static int ipc_host_dma_read(struct intel_ipc_data *iipc, void *dest,
+	uint32_t phy_addr, uint32_t size)
+{
+	int chan;
+
+	chan = ipc_host_dma_start(iipc, dest, phy_addr, size);
+	if (chan < 0)
+		return chan;
+
+	return ipc_host_dma_wait(iipc, chan, dest, size);
+}
+
+/* size of compressed page table, 20 bits for each page, round up to 32 */
+static inline uint32_t page_table_size(struct sof_ipc_host_buffer *ring)
+{
+	return (ring->pages * 5 * 16 + 31) / 32;
+}
+
+/*
+ * Start copying the audio buffer page tables from the host to the DSP, the
+ * table is complete after get_page_descriptors_wait().
+ */
+static int get_page_descriptors_start(struct intel_ipc_data *iipc,
+	struct sof_ipc_host_buffer *ring)
+{
+	if (page_table_size(ring) > PLATFORM_PAGE_TABLE_SIZE) {
+		trace_ipc_error("ePt");
+		return -EINVAL;
+	}
+
+	return ipc_host_dma_start(iipc, iipc->page_table, ring->phy_addr,
+		page_table_size(ring));
+}
+
+static int get_page_descriptors_wait(struct intel_ipc_data *iipc,
+	struct sof_ipc_host_buffer *ring, int chan)
+{
+	return ipc_host_dma_wait(iipc, chan, iipc->page_table,
+		page_table_size(ring));
+}
+
+/*
+ * Copy the audio buffer page tables from the host to the DSP max of 4K.
+ */
+static int get_page_descriptors(struct intel_ipc_data *iipc,
+	struct sof_ipc_host_buffer *ring)
+{
+	int chan;
+
+	chan = get_page_descriptors_start(iipc, ring);
+	if (chan < 0)
+		return chan;
+
+	return get_page_descriptors_wait(iipc, ring, chan);
+}
+
+/* physical address of page in compressed page table */
+static inline uint32_t page_table_addr(uint8_t *page_table, uint32_t page)
+{
+	uint32_t idx = ((page << 2) + page) >> 1;
+	uint32_t phy_addr;
+
+	phy_addr = page_table[idx] | (page_table[idx + 1] << 8) |
+		(page_table[idx + 2] << 16);
+
+	if (page & 0x1)
+		phy_addr <<= 8;
+	else
+		phy_addr <<= 12;
+
+	return phy_addr & 0xfffff000;
+}
+
+/*
+ * Decode the page table into SG elems, contiguous pages are merged into one
+ * elem. Only counts the elems when elems is NULL.
+ */
+static uint32_t page_table_decode(uint8_t *page_table,
+	struct sof_ipc_host_buffer *ring, struct dma_sg_elem *elems,
+	uint32_t is_src)
+{
+	struct dma_sg_elem *elem = NULL;
+	uint32_t phy_addr, run_end = 0;
+	uint32_t count = 0;
+	uint32_t i;
+
+	for (i = 0; i < ring->pages; i++) {
+
+		phy_addr = page_table_addr(page_table, i);
+
+		/* page continues current run ? */
+		if (count && phy_addr == run_end) {
+			if (elem)
+				elem->size += HOST_PAGE_SIZE;
+			run_end += HOST_PAGE_SIZE;
+			continue;
+		}
+
+		/* no, start a new elem */
+		if (elems) {
+			elem = &elems[count];
+			elem->src = is_src ? phy_addr : 0;
+			elem->dest = is_src ? 0 : phy_addr;
+			elem->size = HOST_PAGE_SIZE;
+		}
+
+		count++;
+		run_end = phy_addr + HOST_PAGE_SIZE;
+	}
+
+	return count;
+}
+
+/* decode page table into one array of merged SG elems, caller frees */
+static struct dma_sg_elem *page_table_sg(struct intel_ipc_data *iipc,
+	struct sof_ipc_host_buffer *ring, uint32_t is_src, uint32_t *count)
+{
+	struct dma_sg_elem *elems;
+
+	*count = page_table_decode(iipc->page_table, ring, NULL, is_src);
+	if (*count == 0) {
+		trace_ipc_error("ePe");
+		return NULL;
+	}
+
+	elems = rballoc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*elems) * *count);
+	if (elems == NULL) {
+		trace_ipc_error("ePm");
+		return NULL;
+	}
+
+	page_table_decode(iipc->page_table, ring, elems, is_src);
+	return elems;
+}
+
 /*
  * Parse the host page tables and create the audio DMA SG configuration
- * for host audio DMA buffer. This involves creating a dma_sg_elem for each
- * page table entry and adding each elem to a list in struct dma_sg_config.
+ * for host audio DMA buffer. Contiguous pages are merged and all elems come
+ * from one allocation that is handed over to the component or trace.
  */
 static int parse_page_descriptors(struct intel_ipc_data *iipc,
 	struct sof_ipc_host_buffer *ring, void *data, uint32_t is_trace)
 {
-	struct comp_dev* cd = NULL;
+	struct comp_dev *cd = NULL;
 	struct sof_ipc_comp_host *host = NULL;
-	struct dma_trace_data *d = NULL;
-	struct dma_sg_elem elem;
-	int i, err;
-	uint32_t idx, phy_addr;
+	struct dma_sg_elem *elems;
+	uint32_t count, is_src = 0;
+	int err;
 
-	elem.size = HOST_PAGE_SIZE;
-	if (is_trace)
-		d = (struct dma_trace_data *)data;
-	else {
+	if (!is_trace) {
 		cd = (struct comp_dev *)data;
 		host = (struct sof_ipc_comp_host *)&cd->comp;
+		is_src = host->direction == SOF_IPC_STREAM_PLAYBACK;
 	}
 
-	for (i = 0; i < ring->pages; i++) {
+	elems = page_table_sg(iipc, ring, is_src, &count);
+	if (elems == NULL)
+		return -ENOMEM;
 
-		idx = (((i << 2) + i)) >> 1;
-		phy_addr = iipc->page_table[idx] | (iipc->page_table[idx + 1] << 8)
-				| (iipc->page_table[idx + 2] << 16);
-
-		if (i & 0x1)
-			phy_addr <<= 8;
-		else
-			phy_addr <<= 12;
-		phy_addr &= 0xfffff000;
-
-		if (!is_trace && host->direction == SOF_IPC_STREAM_PLAYBACK)
-			elem.src = phy_addr;
-		else
-			elem.dest = phy_addr;
-
-		if (is_trace)
-			err = dma_trace_host_buffer(d, &elem, ring->size);
-		else
-			err = comp_host_buffer(cd, &elem, ring->size);
-		if (err < 0) {
-			trace_ipc_error("ePb");
-			return err;
-		}
+	/* elems are owned by component or trace on success */
+	if (is_trace)
+		err = dma_trace_host_buffer((struct dma_trace_data *)data,
+			elems, count, ring->size);
+	else
+		err = comp_host_buffer(cd, elems, count, ring->size);
+	if (err < 0) {
+		trace_ipc_error("ePb");
+		rbfree(elems);
+		return err;
 	}
 
 	return 0;
@@ -214,15 +402,27 @@ static int ipc_stream_pcm_params(uint32_t stream)
 	struct sof_ipc_pcm_params_reply reply;
 	struct ipc_comp_dev *pcm_dev;
 	struct comp_dev *cd;
-	int err;
+	int err, chan;
 
 	trace_ipc("SAl");
 
+	/* use DMA to read in compressed page table ringbuffer from host, it
+	 * runs while the stream is looked up and checked.
+	 */
+	chan = get_page_descriptors_start(iipc, &pcm_params->params.buffer);
+	if (chan < 0) {
+		trace_ipc_error("eAp");
+		return chan;
+	}
+
 	/* get the pcm_dev */
-	pcm_dev = ipc_get_comp(_ipc, pcm_params->comp_id);
+	pcm_dev = ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+		pcm_params->comp_id);
 	if (pcm_dev == NULL) {
 		trace_ipc_error("eAC");
 		trace_value(pcm_params->comp_id);
+		get_page_descriptors_wait(iipc, &pcm_params->params.buffer,
+			chan);
 		return -EINVAL;
 	}
 
@@ -230,6 +430,8 @@ static int ipc_stream_pcm_params(uint32_t stream)
 	if (pcm_dev->cd->pipeline == NULL) {
 		trace_ipc_error("eA1");
 		trace_value(pcm_params->comp_id);
+		get_page_descriptors_wait(iipc, &pcm_params->params.buffer,
+			chan);
 		return -EINVAL;
 	}
 
@@ -237,8 +439,8 @@ static int ipc_stream_pcm_params(uint32_t stream)
 	cd = pcm_dev->cd;
 	cd->params = pcm_params->params;
 
-	/* use DMA to read in compressed page table ringbuffer from host */
-	err = get_page_descriptors(iipc, &pcm_params->params.buffer);
+	err = get_page_descriptors_wait(iipc, &pcm_params->params.buffer,
+		chan);
 	if (err < 0) {
 		trace_ipc_error("eAp");
 		goto error;
@@ -273,8 +475,7 @@ static int ipc_stream_pcm_params(uint32_t stream)
 	reply.rhdr.error = 0;
 	reply.comp_id = pcm_params->comp_id;
 	reply.posn_offset = 0; /* TODO: set this up for mmaped components */
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
-	return 1;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
 
 error:
 	err = pipeline_reset(pcm_dev->cd->pipeline, pcm_dev->cd);
@@ -292,7 +493,8 @@ static int ipc_stream_pcm_free(uint32_t header)
 	trace_ipc("SFr");
 
 	/* get the pcm_dev */
-	pcm_dev = ipc_get_comp(_ipc, free_req->comp_id);
+	pcm_dev = ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+		free_req->comp_id);
 	if (pcm_dev == NULL) {
 		trace_ipc_error("eFr");
 		return -ENODEV;
@@ -321,7 +523,8 @@ static int ipc_stream_position(uint32_t header)
 	memset(&posn, 0, sizeof(posn));
 
 	/* get the pcm_dev */
-	pcm_dev = ipc_get_comp(_ipc, stream->comp_id);
+	pcm_dev = ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+		stream->comp_id);
 	if (pcm_dev == NULL) {
 		trace_ipc_error("epo");
 		return -ENODEV;
@@ -336,8 +539,7 @@ static int ipc_stream_position(uint32_t header)
 	pipeline_get_timestamp(pcm_dev->cd->pipeline, pcm_dev->cd, &posn);
 
 	/* copy positions to outbox */
-	mailbox_hostbox_write(0, &posn, sizeof(posn));
-	return 1;
+	return ipc_hostbox_reply(&posn, sizeof(posn));
 }
 
 /* send stream position */
@@ -348,11 +550,12 @@ int ipc_stream_send_position(struct comp_dev *cdev,
 	posn->rhdr.hdr.size = sizeof(*posn);
 	posn->comp_id = cdev->comp.id;
 
-	return ipc_queue_host_message(_ipc, posn->rhdr.hdr.cmd, posn,
-		sizeof(*posn), NULL, 0, NULL, NULL);
+	/* host only needs the newest position for each stream */
+	return ipc_queue_host_notify(_ipc, posn->rhdr.hdr.cmd, posn->comp_id,
+		IPC_MSG_COALESCE | IPC_MSG_BATCH, posn, sizeof(*posn));
 }
 
-/* send stream position TODO: send compound message  */
+/* send stream xrun ahead of any positions */
 int ipc_stream_send_xrun(struct comp_dev *cdev,
 	struct sof_ipc_stream_posn *posn)
 {
@@ -360,8 +563,8 @@ int ipc_stream_send_xrun(struct comp_dev *cdev,
 	posn->rhdr.hdr.size = sizeof(*posn);
 	posn->comp_id = cdev->comp.id;
 
-	return ipc_queue_host_message(_ipc, posn->rhdr.hdr.cmd, posn,
-		sizeof(*posn), NULL, 0, NULL, NULL);
+	return ipc_queue_host_notify(_ipc, posn->rhdr.hdr.cmd, posn->comp_id,
+		IPC_MSG_URGENT, posn, sizeof(*posn));
 }
 
 static int ipc_stream_trigger(uint32_t header)
@@ -375,7 +578,8 @@ static int ipc_stream_trigger(uint32_t header)
 	trace_ipc("tri");
 
 	/* get the pcm_dev */
-	pcm_dev = ipc_get_comp(_ipc, stream->comp_id);
+	pcm_dev = ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+		stream->comp_id);
 	if (pcm_dev == NULL) {
 		trace_ipc_error("eRg");
 		return -ENODEV;
@@ -485,9 +689,80 @@ static int ipc_glb_dai_message(uint32_t header)
  * PM IPC Operations.
  */
 
+static int ipc_compound_run(uint8_t *data, uint32_t size,
+	struct sof_ipc_compound_reply *reply, uint32_t max_cmds);
+
+/* copy topology snapshot between DSP and the host PM context buffer */
+static int ipc_pm_snap_copy(struct intel_ipc_data *iipc,
+	struct sof_ipc_host_buffer *ring, void *data, uint32_t size,
+	uint32_t to_host)
+{
+	struct dma_sg_config config;
+	struct dma_sg_elem *elems;
+	uint32_t count, i;
+	int ret;
+
+	if (size > ring->size) {
+		trace_ipc_error("ePz");
+		return -EINVAL;
+	}
+
+	ret = get_page_descriptors(iipc, ring);
+	if (ret < 0) {
+		trace_ipc_error("ePp");
+		return ret;
+	}
+
+	elems = page_table_sg(iipc, ring, !to_host, &count);
+	if (elems == NULL)
+		return -ENOMEM;
+
+	list_init(&config.elem_list);
+	for (i = 0; i < count; i++)
+		list_item_append(&elems[i].list, &config.elem_list);
+
+	if (to_host) {
+		dcache_writeback_region(data, size);
+		ret = dma_copy_to_host(&config, 0, data, size);
+	} else {
+		ret = dma_copy_from_host(&config, 0, data, size);
+		dcache_invalidate_region(data, size);
+	}
+
+	rbfree(elems);
+	return ret < 0 ? ret : 0;
+}
+
+/* write topology snapshot to host, returns bytes written */
+static int ipc_pm_snap_save(struct intel_ipc_data *iipc,
+	struct sof_ipc_host_buffer *ring)
+{
+	uint32_t size = ipc_snap_size(_ipc);
+	void *data;
+	int ret;
+
+	/* host replays the topology if there is no snapshot */
+	if (size == 0 || size > SOF_IPC_PM_SNAP_MAX_SIZE || ring->pages == 0)
+		return 0;
+
+	data = rballoc(RZONE_RUNTIME, RFLAGS_NONE, size);
+	if (data == NULL) {
+		trace_ipc_error("ePa");
+		return -ENOMEM;
+	}
+
+	ret = ipc_snap_write(_ipc, data, size);
+	if (ret > 0)
+		ret = ipc_pm_snap_copy(iipc, ring, data, size, 1);
+
+	rbfree(data);
+	return ret < 0 ? ret : size;
+}
+
 static int ipc_pm_context_size(uint32_t header)
 {
 	struct sof_ipc_pm_ctx pm_ctx;
+	uint32_t size;
 
 	trace_ipc("PMs");
 
@@ -495,19 +770,33 @@ static int ipc_pm_context_size(uint32_t header)
 
 	/* TODO: calculate the context and size of host buffers required */
 
+	/* topology snapshot size */
+	size = ipc_snap_size(_ipc);
+	if (size <= SOF_IPC_PM_SNAP_MAX_SIZE)
+		pm_ctx.size = size;
+
 	/* write the context to the host driver */
-	mailbox_hostbox_write(0, &pm_ctx, sizeof(pm_ctx));
-	return 1;
+	return ipc_hostbox_reply(&pm_ctx, sizeof(pm_ctx));
 }
 
 static int ipc_pm_context_save(uint32_t header)
 {
+	struct intel_ipc_data *iipc = ipc_get_drvdata(_ipc);
 	struct sof_ipc_pm_ctx *pm_ctx = _ipc->comp_data;
+	int ret;
 
 	trace_ipc("PMs");
 
 	/* TODO: check we are inactive - all streams are suspended */
 
+	/* save the topology while DMA and timers still run */
+	ret = ipc_pm_snap_save(iipc, &pm_ctx->buffer);
+	if (ret < 0) {
+		trace_ipc_error("ePS");
+		ret = 0;
+	}
+	pm_ctx->size = ret;
+
 	/* TODO: mask ALL platform interrupts except DMA */
 
 	/* TODO now save the context - create SG buffer config using */
@@ -528,23 +817,91 @@ static int ipc_pm_context_save(uint32_t header)
 	/* TODO: save the context */
 	//reply.entries_no = 0;
 
-	/* write the context to the host driver */
-	mailbox_hostbox_write(0, pm_ctx, sizeof(*pm_ctx));
-
 	//iipc->pm_prepare_D3 = 1;
 
-	return 1;
+	/* write the context to the host driver */
+	return ipc_hostbox_reply(pm_ctx, sizeof(*pm_ctx));
 }
 
+/* rebuild the graph from the topology snapshot saved before suspend */
 static int ipc_pm_context_restore(uint32_t header)
 {
-//	struct sof_ipc_pm_ctx pm_ctx = _ipc->comp_data;
+	struct intel_ipc_data *iipc = ipc_get_drvdata(_ipc);
+	struct sof_ipc_pm_ctx *pm_ctx = _ipc->comp_data;
+	struct sof_ipc_compound_reply *reply;
+	struct sof_ipc_pm_snap snap;
+	uint32_t size = pm_ctx->size;
+	uint32_t max_status;
+	uint8_t *data;
+	int ret;
 
 	trace_ipc("PMr");
 
-	/* now restore the context */
+	/* no snapshot, host replays the topology */
+	if (size == 0)
+		return 0;
 
-	return 0;
+	if (size < sizeof(snap) + sizeof(struct sof_ipc_compound_hdr) ||
+		size > SOF_IPC_PM_SNAP_MAX_SIZE || size & 0x3) {
+		trace_ipc_error("eRs");
+		trace_value(size);
+		return -EINVAL;
+	}
+
+	/* graph is rebuilt into an empty DSP */
+	if (!list_is_empty(&_ipc->comp_list)) {
+		trace_ipc_error("eRb");
+		return -EBUSY;
+	}
+
+	data = rballoc(RZONE_RUNTIME, RFLAGS_NONE, size);
+	if (data == NULL) {
+		trace_ipc_error("eRa");
+		return -ENOMEM;
+	}
+
+	ret = ipc_pm_snap_copy(iipc, &pm_ctx->buffer, data, size, 0);
+	if (ret < 0) {
+		trace_ipc_error("eRd");
+		goto out;
+	}
+
+	rmemcpy(&snap, data, sizeof(snap));
+	if (snap.magic != SOF_IPC_PM_SNAP_MAGIC || snap.size != size ||
+		snap.count > size / sizeof(struct sof_ipc_hdr)) {
+		trace_ipc_error("eRm");
+		ret = -EINVAL;
+		goto out;
+	}
+
+	reply = rballoc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*reply) +
+		snap.count * sizeof(reply->status[0]));
+	if (reply == NULL) {
+		trace_ipc_error("eRa");
+		ret = -ENOMEM;
+		goto out;
+	}
+	reply->count = 0;
+
+	/* messages are run as a compound sequence */
+	ret = ipc_compound_run(data + sizeof(snap), size - sizeof(snap),
+		reply, snap.count);
+
+	/* reply with as many command status as fit in the mailbox */
+	max_status = (_ipc->host_size - sizeof(*reply)) /
+		sizeof(reply->status[0]);
+	if (max_status > reply->count)
+		max_status = reply->count;
+	reply->rhdr.hdr.size = sizeof(*reply) +
+		max_status * sizeof(reply->status[0]);
+	reply->rhdr.hdr.cmd = header;
+	reply->rhdr.error = ret;
+	ret = ipc_hostbox_reply(reply, reply->rhdr.hdr.size);
+	rbfree(reply);
+
+out:
+	rbfree(data);
+	return ret;
 }
 
 static int ipc_glb_pm_message(uint32_t header)
@@ -588,8 +945,7 @@ static int ipc_dma_trace_init(uint32_t header)
 	reply.hdr.size = sizeof(reply);
 	reply.hdr.cmd = header;
 	reply.error = 0;
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
-	return 0;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
 
 error:
 	if (err < 0)
@@ -631,8 +987,7 @@ static int ipc_dma_trace_config(uint32_t header)
 	reply.hdr.size = sizeof(reply);
 	reply.hdr.cmd = header;
 	reply.error = 0;
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
-	return 0;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
 
 error:
 	if (err < 0)
@@ -640,6 +995,209 @@ error:
 	return -EINVAL;
 }
 
+static int ipc_dma_chan_stats(uint32_t header)
+{
+	struct sof_ipc_dma_chan_stats *req = _ipc->comp_data;
+	struct sof_ipc_dma_chan_stats_reply reply;
+	struct dma_chan_stats stats;
+	struct dma *dma;
+	int err;
+
+	trace_ipc("DSt");
+
+	dma = dma_get(req->dmac_id);
+	if (dma == NULL) {
+		trace_ipc_error("eSd");
+		return -ENODEV;
+	}
+
+	err = dma_stats(dma, req->channel, &stats);
+	if (err < 0) {
+		trace_ipc_error("eSc");
+		return err;
+	}
+
+	/* write channel statistics to the outbox */
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.rhdr.error = 0;
+	reply.dmac_id = req->dmac_id;
+	reply.channel = req->channel;
+	reply.priority = stats.prio;
+	reply.state = stats.state;
+	reply.bytes = stats.bytes;
+	reply.irqs = stats.irqs;
+	reply.errors = stats.errors;
+	reply.reload_last = stats.reload_last;
+	reply.reload_max = stats.reload_max;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
+}
+
+/* dump command statistics of all classes to trace */
+static void ipc_stats_trace(void)
+{
+	struct ipc_cmd_stats *cs;
+	int i;
+
+	for (i = 0; i < IPC_STATS_CLASSES; i++) {
+		cs = &_ipc->stats.cmd[i];
+		if (cs->count == 0)
+			continue;
+
+		trace_ipc("ISc");
+		trace_value(i + 1);
+		trace_value(cs->count);
+		trace_value(cs->errors);
+		trace_value(cs->queue_max);
+		trace_value(cs->exec_max);
+	}
+
+	trace_ipc("ISx");
+	trace_value(_ipc->stats.tx_count);
+	trace_value(_ipc->stats.tx_coalesced);
+	trace_value(_ipc->stats.tx_dropped);
+	trace_value(_ipc->stats.tx_depth_max);
+	trace_value(_ipc->stats.tx_ack_max);
+}
+
+static int ipc_ipc_stats(uint32_t header)
+{
+	struct sof_ipc_ipc_stats *req = _ipc->comp_data;
+	struct sof_ipc_ipc_stats_reply reply;
+	struct ipc_stats *stats = &_ipc->stats;
+	struct ipc_cmd_stats *cs;
+	uint32_t type = iGS(req->glb_type);
+	int i;
+
+	trace_ipc("ISt");
+
+	bzero(&reply, sizeof(reply));
+
+	if (type == 0)
+		ipc_stats_trace();
+	else if (type > IPC_STATS_CLASSES) {
+		trace_ipc_error("eSt");
+		return -EINVAL;
+	} else {
+		cs = &stats->cmd[type - 1];
+		reply.count = cs->count;
+		reply.errors = cs->errors;
+		reply.queue_max = cs->queue_max;
+		reply.exec_max = cs->exec_max;
+		for (i = 0; i < SOF_IPC_STATS_BINS; i++)
+			reply.hist[i] = cs->hist[i];
+	}
+
+	/* write statistics to the outbox */
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.rhdr.error = 0;
+	reply.glb_type = req->glb_type;
+	reply.clock_hz = clock_get_freq(PLATFORM_SCHED_CLOCK);
+	reply.tx_count = stats->tx_count;
+	reply.tx_coalesced = stats->tx_coalesced;
+	reply.tx_dropped = stats->tx_dropped;
+	reply.tx_depth_max = stats->tx_depth_max;
+	reply.tx_ack_max = stats->tx_ack_max;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
+}
+
+static int ipc_trace_level(uint32_t header)
+{
+	struct sof_ipc_trace_level *req = _ipc->comp_data;
+	struct sof_ipc_trace_level_reply reply;
+	int i;
+
+	trace_ipc("TLv");
+
+	if (req->set >> SOF_IPC_TRACE_LEVELS) {
+		trace_ipc_error("eTL");
+		trace_value(req->set);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < SOF_IPC_TRACE_LEVELS; i++) {
+		if (req->set & (1 << i))
+			trace_set_mask(i, req->class_mask[i]);
+		reply.class_mask[i] = trace_mask[i];
+	}
+
+	/* write current masks to the outbox */
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.rhdr.error = 0;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
+}
+
+static int ipc_trace_profile(uint32_t header)
+{
+	struct sof_ipc_trace_profile *req = _ipc->comp_data;
+
+	trace_ipc("TPr");
+
+	if (req->rate_hz == 0) {
+		profile_stop();
+		return 0;
+	}
+
+	return profile_start(req->rate_hz, req->report_ms);
+}
+
+static int ipc_trace_watermark(uint32_t header)
+{
+	struct sof_ipc_trace_watermark *req = _ipc->comp_data;
+	struct sof_ipc_trace_watermark_reply reply;
+	uint32_t mhz = clock_get_freq(CLK_CPU) / 1000000;
+
+	trace_ipc("TWm");
+
+	reply.stack_size = stack_size();
+	reply.stack_used = stack_used();
+	reply.irq_off_cycles = irq_off_wm.max;
+	reply.irq_off_us = mhz ? irq_off_wm.max / mhz : 0;
+	reply.irq_off_site = irq_off_wm.max_site;
+
+	if (req->reset)
+		watermark_reset();
+
+	/* write watermarks to the outbox */
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.rhdr.error = 0;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
+}
+
+static int ipc_trace_load(uint32_t header)
+{
+	struct sof_ipc_trace_load *req = _ipc->comp_data;
+	struct sof_ipc_trace_load_reply reply;
+
+	trace_ipc("TLd");
+
+	load_report(&reply, req->reset_peak);
+
+	/* write loads to the outbox */
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.rhdr.error = 0;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
+}
+
+static int ipc_trace_xrun(uint32_t header)
+{
+	struct sof_ipc_trace_xrun_reply reply;
+
+	trace_ipc("TXr");
+
+	pipeline_get_xrun(&reply);
+
+	/* write post-mortem record to the outbox */
+	reply.rhdr.hdr.size = sizeof(reply);
+	reply.rhdr.hdr.cmd = header;
+	reply.rhdr.error = 0;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
+}
+
 static int ipc_glb_debug_message(uint32_t header)
 {
 	uint32_t cmd = (header & SOF_CMD_TYPE_MASK) >> SOF_CMD_TYPE_SHIFT;
@@ -651,6 +1209,20 @@ static int ipc_glb_debug_message(uint32_t header)
 		return ipc_dma_trace_init(header);
 	case iCS(SOF_IPC_TRACE_DMA_PARAMS):
 		return ipc_dma_trace_config(header);
+	case iCS(SOF_IPC_TRACE_DMA_CHAN_STATS):
+		return ipc_dma_chan_stats(header);
+	case iCS(SOF_IPC_TRACE_IPC_STATS):
+		return ipc_ipc_stats(header);
+	case iCS(SOF_IPC_TRACE_LEVEL):
+		return ipc_trace_level(header);
+	case iCS(SOF_IPC_TRACE_PROFILE):
+		return ipc_trace_profile(header);
+	case iCS(SOF_IPC_TRACE_WATERMARK):
+		return ipc_trace_watermark(header);
+	case iCS(SOF_IPC_TRACE_LOAD):
+		return ipc_trace_load(header);
+	case iCS(SOF_IPC_TRACE_XRUN):
+		return ipc_trace_xrun(header);
 	default:
 		trace_ipc_error("eDc");
 		trace_value(header);
@@ -663,16 +1235,16 @@ static int ipc_glb_debug_message(uint32_t header)
  */
 
 /* get/set component values or runtime data */
-static int ipc_comp_value(uint32_t header, uint32_t cmd)
+static int ipc_comp_value(struct sof_ipc_ctrl_data *data, uint32_t cmd)
 {
 	struct ipc_comp_dev *stream_dev;
-	struct sof_ipc_ctrl_data *data = _ipc->comp_data;
 	int ret;
 
 	trace_ipc("VoG");
 
 	/* get the component */
-	stream_dev = ipc_get_comp(_ipc, data->comp_id);
+	stream_dev = ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+		data->comp_id);
 	if (stream_dev == NULL){
 		trace_ipc_error("eVg");
 		trace_value(data->comp_id);
@@ -686,27 +1258,171 @@ static int ipc_comp_value(uint32_t header, uint32_t cmd)
 		return ret;
 	}
 
+	/* keep new control values for the PM topology snapshot */
+	if (cmd == COMP_CMD_SET_VALUE || cmd == COMP_CMD_SET_DATA)
+		ipc_snap_ctrl(_ipc, data->rhdr.hdr.cmd, data);
+
 	/* write component values to the outbox */
-	mailbox_hostbox_write(0, data, data->rhdr.hdr.size);
-	return 1;
+	return ipc_hostbox_reply(data, data->rhdr.hdr.size);
 }
 
-static int ipc_glb_comp_message(uint32_t header)
+/* component command for control type or -EINVAL */
+static int ipc_ctrl_type_cmd(uint32_t type)
 {
-	uint32_t cmd = (header & SOF_CMD_TYPE_MASK) >> SOF_CMD_TYPE_SHIFT;
+	switch (type) {
+	case SOF_CTRL_TYPE_VALUE_CHAN_GET:
+	case SOF_CTRL_TYPE_VALUE_COMP_GET:
+		return COMP_CMD_GET_VALUE;
+	case SOF_CTRL_TYPE_VALUE_CHAN_SET:
+	case SOF_CTRL_TYPE_VALUE_COMP_SET:
+		return COMP_CMD_SET_VALUE;
+	case SOF_CTRL_TYPE_DATA_GET:
+		return COMP_CMD_GET_DATA;
+	case SOF_CTRL_TYPE_DATA_SET:
+		return COMP_CMD_SET_DATA;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* check every bulk item before any are applied, returns bad item count */
+static int ipc_comp_bulk_validate(struct sof_ipc_ctrl_bulk *bulk)
+{
+	struct sof_ipc_ctrl_data *data;
+	uint32_t offset = sizeof(*bulk);
+	uint32_t size = bulk->rhdr.hdr.size;
+	uint32_t i;
+	int bad = 0;
+
+	if (bulk->count > SOF_IPC_CTRL_BULK_MAX) {
+		trace_ipc_error("eKn");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < bulk->count; i++) {
+
+		/* items must fit and stay word aligned */
+		data = (struct sof_ipc_ctrl_data *)((uint8_t *)bulk + offset);
+		if (offset + sizeof(*data) > size ||
+			data->rhdr.hdr.size < sizeof(*data) ||
+			data->rhdr.hdr.size > size - offset ||
+			data->rhdr.hdr.size & 0x3) {
+			trace_ipc_error("eKs");
+			trace_value(i);
+			return -EINVAL;
+		}
+		offset += data->rhdr.hdr.size;
+
+		data->rhdr.error = 0;
+		if (ipc_ctrl_type_cmd(data->type) < 0) {
+			trace_ipc_error("eKt");
+			data->rhdr.error = -EINVAL;
+			bad++;
+		} else if (ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+			data->comp_id) == NULL) {
+			trace_ipc_error("eKc");
+			trace_value(data->comp_id);
+			data->rhdr.error = -ENODEV;
+			bad++;
+		}
+	}
+
+	return bad;
+}
+
+/*
+ * Get/set many controls with one message. Pipeline tasks run at a higher
+ * priority than IPC so their IRQs are masked while the items are applied,
+ * every set then lands between the same two periods. Task IRQs that were
+ * already masked by our caller stay masked.
+ */
+static int ipc_comp_bulk(struct sof_ipc_ctrl_bulk *bulk)
+{
+	struct sof_ipc_ctrl_data *data;
+	struct ipc_comp_dev *comp_dev;
+	uint32_t offset = sizeof(*bulk);
+	uint32_t i, enabled;
+	int ret, cmd;
+
+	trace_ipc("VoB");
+
+	if (bulk->rhdr.hdr.size < sizeof(*bulk)) {
+		trace_ipc_error("eKs");
+		return -EINVAL;
+	}
+
+	ret = ipc_comp_bulk_validate(bulk);
+	if (ret < 0)
+		return ret;
+
+	/* nothing is applied if any item is bad */
+	bulk->rhdr.error = 0;
+	if (ret > 0) {
+		bulk->rhdr.error = -EINVAL;
+		return ipc_hostbox_reply(bulk, bulk->rhdr.hdr.size);
+	}
+
+	enabled = interrupt_disable(PLATFORM_IRQ_TASK_HIGH);
+	interrupt_disable(PLATFORM_IRQ_TASK_MED);
+
+	for (i = 0; i < bulk->count; i++) {
+		data = (struct sof_ipc_ctrl_data *)((uint8_t *)bulk + offset);
+		offset += data->rhdr.hdr.size;
+
+		comp_dev = ipc_get_comp_type(_ipc, COMP_TYPE_COMPONENT,
+			data->comp_id);
+		data->rhdr.error = comp_cmd(comp_dev->cd,
+			ipc_ctrl_type_cmd(data->type), data);
+		if (data->rhdr.error < 0)
+			bulk->rhdr.error = data->rhdr.error;
+	}
+
+	/* restore the mask we found */
+	if (enabled & (1 << PLATFORM_IRQ_TASK_MED))
+		interrupt_enable(PLATFORM_IRQ_TASK_MED);
+	if (enabled & (1 << PLATFORM_IRQ_TASK_HIGH))
+		interrupt_enable(PLATFORM_IRQ_TASK_HIGH);
+
+	/* keep new control values for the PM topology snapshot */
+	offset = sizeof(*bulk);
+	for (i = 0; i < bulk->count; i++) {
+		data = (struct sof_ipc_ctrl_data *)((uint8_t *)bulk + offset);
+		offset += data->rhdr.hdr.size;
+
+		cmd = ipc_ctrl_type_cmd(data->type);
+		if (data->rhdr.error < 0 || cmd == COMP_CMD_GET_VALUE ||
+			cmd == COMP_CMD_GET_DATA)
+			continue;
+
+		ipc_snap_ctrl(_ipc, SOF_IPC_GLB_COMP_MSG |
+			(cmd == COMP_CMD_SET_DATA ? SOF_IPC_COMP_SET_DATA :
+			SOF_IPC_COMP_SET_VALUE), data);
+	}
+
+	/* one reply carries every status and get value */
+	return ipc_hostbox_reply(bulk, bulk->rhdr.hdr.size);
+}
+
+/* data is in comp_data or pinned in the host mailbox */
+static int ipc_glb_comp_message(struct sof_ipc_hdr *hdr)
+{
+	struct sof_ipc_ctrl_data *data = (struct sof_ipc_ctrl_data *)hdr;
+	uint32_t cmd = (hdr->cmd & SOF_CMD_TYPE_MASK) >> SOF_CMD_TYPE_SHIFT;
 
 	switch (cmd) {
 	case iCS(SOF_IPC_COMP_SET_VALUE):
-		return ipc_comp_value(header, COMP_CMD_SET_VALUE);
+		return ipc_comp_value(data, COMP_CMD_SET_VALUE);
 	case iCS(SOF_IPC_COMP_GET_VALUE):
-		return ipc_comp_value(header, COMP_CMD_GET_VALUE);
+		return ipc_comp_value(data, COMP_CMD_GET_VALUE);
 	case iCS(SOF_IPC_COMP_SET_DATA):
-		return ipc_comp_value(header, COMP_CMD_SET_DATA);
+		return ipc_comp_value(data, COMP_CMD_SET_DATA);
 	case iCS(SOF_IPC_COMP_GET_DATA):
-		return ipc_comp_value(header, COMP_CMD_GET_DATA);
+		return ipc_comp_value(data, COMP_CMD_GET_DATA);
+	case iCS(SOF_IPC_COMP_BULK):
+		return ipc_comp_bulk((struct sof_ipc_ctrl_bulk *)hdr);
 	default:
 		trace_ipc_error("eCc");
-		trace_value(header);
+		trace_value(hdr->cmd);
 		return -EINVAL;
 	}
 }
@@ -731,8 +1447,7 @@ static int ipc_glb_tplg_comp_new(uint32_t header)
 	reply.rhdr.hdr.cmd = header;
 	reply.rhdr.error = 0;
 	reply.offset = 0; /* TODO: set this up for mmaped components */
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
-	return 1;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
 }
 
 static int ipc_glb_tplg_buffer_new(uint32_t header)
@@ -754,8 +1469,7 @@ static int ipc_glb_tplg_buffer_new(uint32_t header)
 	reply.rhdr.hdr.cmd = header;
 	reply.rhdr.error = 0;
 	reply.offset = 0; /* TODO: set this up for mmaped components */
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
-	return 1;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
 }
 
 static int ipc_glb_tplg_pipe_new(uint32_t header)
@@ -777,8 +1491,7 @@ static int ipc_glb_tplg_pipe_new(uint32_t header)
 	reply.rhdr.hdr.cmd = header;
 	reply.rhdr.error = 0;
 	reply.offset = 0; /* TODO: set this up for mmaped components */
-	mailbox_hostbox_write(0, &reply, sizeof(reply));
-	return 1;
+	return ipc_hostbox_reply(&reply, sizeof(reply));
 }
 
 static int ipc_glb_tplg_pipe_complete(uint32_t header)
@@ -846,30 +1559,25 @@ static int ipc_glb_tplg_message(uint32_t header)
  * Global IPC Operations.
  */
 
-int ipc_cmd(void)
+static int ipc_glb_compound_message(uint32_t header);
+
+static int ipc_glb_cmd(struct sof_ipc_hdr *hdr)
 {
-	struct sof_ipc_hdr *hdr;
 	uint32_t type;
 
-	hdr = mailbox_validate();
-	if (hdr == NULL) {
-		trace_ipc_error("hdr");
-		return -EINVAL;
-	}
-
 	type = (hdr->cmd & SOF_GLB_TYPE_MASK) >> SOF_GLB_TYPE_SHIFT;
 
 	switch (type) {
 	case iGS(SOF_IPC_GLB_REPLY):
 		return 0;
 	case iGS(SOF_IPC_GLB_COMPOUND):
-		return -EINVAL;	/* TODO */
+		return ipc_glb_compound_message(hdr->cmd);
 	case iGS(SOF_IPC_GLB_TPLG_MSG):
 		return ipc_glb_tplg_message(hdr->cmd);
 	case iGS(SOF_IPC_GLB_PM_MSG):
 		return ipc_glb_pm_message(hdr->cmd);
 	case iGS(SOF_IPC_GLB_COMP_MSG):
-		return ipc_glb_comp_message(hdr->cmd);
+		return ipc_glb_comp_message(hdr);
 	case iGS(SOF_IPC_GLB_STREAM_MSG):
 		return ipc_glb_stream_message(hdr->cmd);
 	case iGS(SOF_IPC_GLB_DAI_MSG):
@@ -883,6 +1591,284 @@ int ipc_cmd(void)
 	}
 }
 
+/*
+ * Compound IPC Operations.
+ */
+
+/* run each command in the blocks, commands may be unaligned in the payload */
+static int ipc_compound_run(uint8_t *data, uint32_t size,
+	struct sof_ipc_compound_reply *reply, uint32_t max_cmds)
+{
+	struct sof_ipc_compound_hdr block;
+	struct sof_ipc_hdr hdr;
+	uint32_t offset = 0;
+	uint32_t i;
+	int ret;
+
+	while (offset + sizeof(block) <= size) {
+
+		rmemcpy(&block, data + offset, sizeof(block));
+		offset += sizeof(block);
+
+		/* end of sequence ? */
+		if (block.count == 0)
+			return 0;
+
+		for (i = 0; i < block.count; i++) {
+
+			/* validate command size */
+			if (offset + sizeof(hdr) > size) {
+				trace_ipc_error("eXs");
+				return -EINVAL;
+			}
+			rmemcpy(&hdr, data + offset, sizeof(hdr));
+			if (hdr.size < sizeof(hdr) ||
+				hdr.size > SOF_IPC_MSG_MAX_SIZE ||
+				offset + hdr.size > size) {
+				trace_ipc_error("eXs");
+				trace_value(hdr.size);
+				return -EINVAL;
+			}
+
+			/* command must match block type and can't be compound */
+			if ((hdr.cmd & SOF_GLB_TYPE_MASK) !=
+				(block.hdr.cmd & SOF_GLB_TYPE_MASK) ||
+				(hdr.cmd & SOF_GLB_TYPE_MASK) ==
+				SOF_IPC_GLB_COMPOUND) {
+				trace_ipc_error("eXt");
+				trace_value(hdr.cmd);
+				return -EINVAL;
+			}
+
+			if (reply->count == max_cmds) {
+				trace_ipc_error("eXc");
+				return -EINVAL;
+			}
+
+			/* handlers read their command from comp_data */
+			rmemcpy(_ipc->comp_data, data + offset, hdr.size);
+			offset += hdr.size;
+
+			/* any command reply is replaced by the compound reply */
+			ret = ipc_glb_cmd(_ipc->comp_data);
+			reply->status[reply->count++] = ret < 0 ? ret : 0;
+			if (ret < 0) {
+				trace_ipc_error("eXr");
+				trace_value(hdr.cmd);
+				return ret;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int ipc_glb_compound_message(uint32_t header)
+{
+	struct intel_ipc_data *iipc = ipc_get_drvdata(_ipc);
+	uint32_t cmd = (header & SOF_CMD_TYPE_MASK) >> SOF_CMD_TYPE_SHIFT;
+	struct sof_ipc_compound_dma *cdma = _ipc->comp_data;
+	struct sof_ipc_compound_reply *reply;
+	struct sof_ipc_hdr *hdr = _ipc->comp_data;
+	uint8_t *data;
+	uint32_t size;
+	uint32_t max_cmds;
+	int ret;
+
+	trace_ipc("Cmp");
+
+	/* get payload size and read rest of the DMA descriptor */
+	switch (cmd) {
+	case iCS(SOF_IPC_COMPOUND_MAILBOX):
+		if (hdr->size < sizeof(*hdr) ||
+			hdr->size > _ipc->host_size) {
+			trace_ipc_error("eXm");
+			return -EINVAL;
+		}
+		size = hdr->size - sizeof(*hdr);
+		break;
+	case iCS(SOF_IPC_COMPOUND_DMA):
+		if (hdr->size != sizeof(*cdma)) {
+			trace_ipc_error("eXd");
+			return -EINVAL;
+		}
+		mailbox_hostbox_read(cdma, _ipc->host_offset, sizeof(*cdma));
+		if (cdma->size > SOF_IPC_COMPOUND_MAX_SIZE ||
+			cdma->size & 0x3) {
+			trace_ipc_error("eXd");
+			trace_value(cdma->size);
+			return -EINVAL;
+		}
+		size = cdma->size;
+		break;
+	default:
+		trace_ipc_error("eXx");
+		trace_value(header);
+		return -EINVAL;
+	}
+
+	if (size < sizeof(struct sof_ipc_compound_hdr)) {
+		trace_ipc_error("eXe");
+		return -EINVAL;
+	}
+
+	/* payload must be copied, command replies overwrite the mailbox */
+	data = rballoc(RZONE_RUNTIME, RFLAGS_NONE, size);
+	if (data == NULL) {
+		trace_ipc_error("eXa");
+		return -ENOMEM;
+	}
+
+	reply = rzalloc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*reply) +
+		SOF_IPC_COMPOUND_MAX_CMDS * sizeof(reply->status[0]));
+	if (reply == NULL) {
+		trace_ipc_error("eXa");
+		rbfree(data);
+		return -ENOMEM;
+	}
+
+	if (cmd == iCS(SOF_IPC_COMPOUND_DMA)) {
+		ret = ipc_host_dma_read(iipc, data, cdma->phy_addr, size);
+		if (ret < 0) {
+			trace_ipc_error("eXD");
+			goto out;
+		}
+	} else {
+		mailbox_hostbox_read(data, _ipc->host_offset + sizeof(*hdr),
+			size);
+	}
+
+	/* reply status must fit in the command mailbox space */
+	max_cmds = (_ipc->host_size - sizeof(*reply)) /
+		sizeof(reply->status[0]);
+	if (max_cmds > SOF_IPC_COMPOUND_MAX_CMDS)
+		max_cmds = SOF_IPC_COMPOUND_MAX_CMDS;
+
+	ret = ipc_compound_run(data, size, reply, max_cmds);
+
+	/* write status of each command to the outbox */
+	reply->rhdr.hdr.size = sizeof(*reply) +
+		reply->count * sizeof(reply->status[0]);
+	reply->rhdr.hdr.cmd = header;
+	reply->rhdr.error = ret;
+	ret = ipc_hostbox_reply(reply, reply->rhdr.hdr.size);
+
+out:
+	rfree(reply);
+	rbfree(data);
+	return ret;
+}
+
+/*
+ * IPC Statistics.
+ */
+
+/* bin n holds latencies below 1 << (IPC_STATS_BIN_SHIFT + n) ticks */
+static inline int ipc_stats_bin(uint32_t ticks)
+{
+	int bin = 0;
+
+	ticks >>= IPC_STATS_BIN_SHIFT;
+	while (ticks && bin < SOF_IPC_STATS_BINS - 1) {
+		ticks >>= 1;
+		bin++;
+	}
+
+	return bin;
+}
+
+static void ipc_stats_cmd(uint32_t cmd, uint64_t start, uint64_t end,
+	int err)
+{
+	struct ipc_cmd_stats *cs;
+	uint32_t type = iGS(cmd);
+	uint32_t queue = (uint32_t)(start - _ipc->host_rx_time);
+	uint32_t exec = (uint32_t)(end - start);
+
+	if (type == 0 || type > IPC_STATS_CLASSES)
+		return;
+
+	cs = &_ipc->stats.cmd[type - 1];
+	cs->count++;
+	if (err < 0)
+		cs->errors++;
+	if (queue > cs->queue_max)
+		cs->queue_max = queue;
+	if (exec > cs->exec_max)
+		cs->exec_max = exec;
+	cs->hist[ipc_stats_bin(queue + exec)]++;
+}
+
+/* message sent to host, locks held by caller */
+void ipc_stats_tx_sent(struct ipc *ipc, uint32_t count)
+{
+	ipc->stats.tx_count += count;
+	ipc->stats.tx_time = platform_timer_get(platform_timer);
+}
+
+/* host has acked last message, locks held by caller */
+void ipc_stats_tx_ack(struct ipc *ipc)
+{
+	uint32_t delta = (uint32_t)(platform_timer_get(platform_timer) -
+		ipc->stats.tx_time);
+
+	if (delta > ipc->stats.tx_ack_max)
+		ipc->stats.tx_ack_max = delta;
+}
+
+int ipc_cmd(void)
+{
+	struct sof_ipc_hdr *hdr;
+	uint64_t start;
+	uint32_t cmd;
+	int ret;
+
+	hdr = mailbox_validate();
+	if (hdr == NULL) {
+		trace_ipc_error("hdr");
+		return -EINVAL;
+	}
+
+	/* header is overwritten by compound commands */
+	cmd = hdr->cmd;
+	start = platform_timer_get(platform_timer);
+
+	ret = ipc_glb_cmd(hdr);
+
+	ipc_stats_cmd(cmd, start, platform_timer_get(platform_timer), ret);
+	return ret;
+}
+
+/*
+ * Commands that wait on DMA completion or power down must run from the idle
+ * loop at interrupt level 0, the IPC task IRQ can't sleep in waiti.
+ */
+int ipc_cmd_blocking(void)
+{
+	struct sof_ipc_hdr hdr;
+
+	if (interrupt_get_level() == 0)
+		return 0;
+
+	mailbox_hostbox_read(&hdr, _ipc->host_offset, sizeof(hdr));
+
+	switch (hdr.cmd & SOF_GLB_TYPE_MASK) {
+	case SOF_IPC_GLB_COMPOUND:
+	case SOF_IPC_GLB_PM_MSG:
+		return 1;
+	case SOF_IPC_GLB_STREAM_MSG:
+		/* page table read and pipeline preload */
+		return (hdr.cmd & SOF_CMD_TYPE_MASK) ==
+			SOF_IPC_STREAM_PCM_PARAMS;
+	case SOF_IPC_GLB_TRACE_MSG:
+		/* page table read */
+		return (hdr.cmd & SOF_CMD_TYPE_MASK) ==
+			SOF_IPC_TRACE_DMA_PARAMS;
+	default:
+		return 0;
+	}
+}
+
 /* locks held by caller */
 static inline struct ipc_msg *msg_get_empty(struct ipc *ipc)
 {
@@ -896,6 +1882,65 @@ static inline struct ipc_msg *msg_get_empty(struct ipc *ipc)
 	return msg;
 }
 
+/* find queued message of same type for the same ID, locks held by caller */
+static struct ipc_msg *msg_find(struct ipc *ipc, uint32_t header, uint32_t id)
+{
+	struct ipc_msg *msg;
+	struct list_item *plist;
+
+	list_for_item(plist, &ipc->msg_list) {
+		msg = container_of(plist, struct ipc_msg, list);
+		if (msg->header == header && msg->id == id &&
+			(msg->flags & IPC_MSG_COALESCE))
+			return msg;
+	}
+
+	return NULL;
+}
+
+/* take newest routine message for an urgent one, locks held by caller */
+static struct ipc_msg *msg_steal(struct ipc *ipc)
+{
+	struct ipc_msg *msg;
+	struct list_item *plist;
+
+	list_for_item_prev(plist, &ipc->msg_list) {
+		msg = container_of(plist, struct ipc_msg, list);
+		if ((msg->flags & IPC_MSG_COALESCE) && msg->cb == NULL) {
+			list_item_del(&msg->list);
+			ipc->stats.tx_depth--;
+			ipc->stats.tx_dropped++;
+			return msg;
+		}
+	}
+
+	return NULL;
+}
+
+/* urgent messages go ahead of routine ones, locks held by caller */
+static void msg_queue(struct ipc *ipc, struct ipc_msg *msg)
+{
+	struct ipc_msg *m;
+	struct list_item *plist;
+
+	if (++ipc->stats.tx_depth > ipc->stats.tx_depth_max)
+		ipc->stats.tx_depth_max = ipc->stats.tx_depth;
+
+	if (msg->flags & IPC_MSG_URGENT) {
+		list_for_item(plist, &ipc->msg_list) {
+			m = container_of(plist, struct ipc_msg, list);
+			if (!(m->flags & IPC_MSG_URGENT)) {
+				/* insert before first routine message */
+				list_item_append(&msg->list, &m->list);
+				ipc->dsp_pending = 1;
+				return;
+			}
+		}
+	}
+
+	list_item_append(&msg->list, &ipc->msg_list);
+	ipc->dsp_pending = 1;
+}
 
 int ipc_queue_host_message(struct ipc *ipc, uint32_t header,
 	void *tx_data, size_t tx_bytes, void *rx_data,
@@ -911,36 +1956,115 @@ int ipc_queue_host_message(struct ipc *ipc, uint32_t header,
 	msg = msg_get_empty(ipc);
 	if (msg == NULL) {
 		trace_ipc_error("eQb");
+		ipc->stats.tx_dropped++;
 		ret = -EBUSY;
 		goto out;
 	}
 
 	/* prepare the message */
 	msg->header = header;
+	msg->id = 0;
+	msg->flags = 0;
 	msg->tx_size = tx_bytes;
 	msg->rx_size = rx_bytes;
 	msg->cb_data = cb_data;
 	msg->cb = cb;
 
+	/* write straight to the mailbox if it's idle */
+	if (tx_bytes <= SOF_IPC_MSG_MAX_SIZE &&
+		ipc_platform_send_direct(ipc, msg, tx_data) == 0)
+		goto out;
+
 	/* copy mailbox data to message */
-	if (tx_bytes > 0 && tx_bytes < SOF_IPC_MSG_MAX_SIZE)
+	if (tx_bytes > 0 && tx_bytes <= SOF_IPC_MSG_MAX_SIZE)
 		rmemcpy(msg->tx_data, tx_data, tx_bytes);
 
 	/* now queue the message */
-	ipc->dsp_pending = 1;
-	list_item_append(&msg->list, &ipc->msg_list);
+	msg_queue(ipc, msg);
 
 out:
 	spin_unlock_irq(&ipc->lock, flags);
+
+	if (ipc->dsp_pending)
+		ipc_schedule_process(ipc);
+	return ret;
+}
+
+/*
+ * Queue a notification that needs no host reply data. Coalesced messages
+ * replace any queued message of the same type and ID, urgent messages are
+ * sent first and may take the slot of a routine message when the queue is
+ * full.
+ */
+int ipc_queue_host_notify(struct ipc *ipc, uint32_t header, uint32_t id,
+	uint32_t flags, void *tx_data, size_t tx_bytes)
+{
+	struct ipc_msg *msg = NULL;
+	uint32_t lflags;
+	int ret = 0;
+
+	if (tx_bytes > SOF_IPC_MSG_MAX_SIZE)
+		return -EINVAL;
+
+	spin_lock_irq(&ipc->lock, lflags);
+
+	/* newest data replaces queued data */
+	if (flags & IPC_MSG_COALESCE) {
+		msg = msg_find(ipc, header, id);
+		if (msg != NULL) {
+			rmemcpy(msg->tx_data, tx_data, tx_bytes);
+			msg->tx_size = tx_bytes;
+			ipc->stats.tx_coalesced++;
+			goto out;
+		}
+	}
+
+	msg = msg_get_empty(ipc);
+	if (msg == NULL && (flags & IPC_MSG_URGENT)) {
+		tracev_ipc("Qst");
+		msg = msg_steal(ipc);
+	}
+	if (msg == NULL) {
+		trace_ipc_error("eQb");
+		ipc->stats.tx_dropped++;
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/* prepare the message */
+	msg->header = header;
+	msg->id = id;
+	msg->flags = flags;
+	msg->tx_size = tx_bytes;
+	msg->rx_size = 0;
+	msg->cb_data = NULL;
+	msg->cb = NULL;
+
+	/* write straight to the mailbox if it's idle */
+	if (ipc_platform_send_direct(ipc, msg, tx_data) == 0)
+		goto out;
+
+	rmemcpy(msg->tx_data, tx_data, tx_bytes);
+	msg_queue(ipc, msg);
+
+out:
+	spin_unlock_irq(&ipc->lock, lflags);
+
+	if (ipc->dsp_pending)
+		ipc_schedule_process(ipc);
 	return ret;
 }
 
-/* process current message */
+/* idle loop - run blocking commands and make sure the IPC task runs */
 int ipc_process_msg_queue(void)
 {
-	if (_ipc->host_pending)
+	/* task leaves commands alone until this clears idle_pending */
+	if (_ipc->idle_pending) {
 		ipc_platform_do_cmd(_ipc);
-	if (_ipc->dsp_pending)
-		ipc_platform_send_msg(_ipc);
+		_ipc->idle_pending = 0;
+	}
+
+	if (_ipc->host_pending || _ipc->rx_pending || _ipc->dsp_pending)
+		ipc_schedule_process(_ipc);
 	return 0;
 }
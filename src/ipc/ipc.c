@@ -39,42 +39,280 @@
 #include <reef/alloc.h>
 #include <reef/ipc.h>
 #include <reef/debug.h>
+#include <reef/schedule.h>
+#include <platform/platform.h>
 #include <reef/audio/component.h>
 #include <reef/audio/pipeline.h>
 #include <reef/audio/buffer.h>
 
 /*
- * Components, buffers and pipelines all use the same set of monotonic ID
- * numbers passed in by the host. They are stored in different lists, hence
- * more than 1 list may need to be searched for the correspodning component.
+ * Components, buffers and pipelines use the IDs passed in by the host and
+ * are looked up in a hash table per object type. The bucket is the low bits
+ * of the ID, so a lookup only walks objects of the same type that share the
+ * bucket. All objects are also kept on one list for walks and teardown.
  */
 
-struct ipc_comp_dev *ipc_get_comp(struct ipc *ipc, uint32_t id)
+static inline struct list_item *ipc_comp_bucket(struct ipc *ipc,
+	uint16_t type, uint32_t id)
+{
+	return &ipc->comp_hash[type - 1][id & (IPC_COMP_HASH_SIZE - 1)];
+}
+
+/* add new IPC object to the component list and its ID hash bucket */
+static void ipc_comp_add(struct ipc *ipc, struct ipc_comp_dev *icd,
+	uint16_t type, uint32_t id)
+{
+	icd->type = type;
+	icd->id = id;
+	list_item_append(&icd->list, &ipc->comp_list);
+	list_item_prepend(&icd->hash_list, ipc_comp_bucket(ipc, type, id));
+}
+
+static void ipc_comp_del(struct ipc_comp_dev *icd)
+{
+	list_item_del(&icd->hash_list);
+	list_item_del(&icd->list);
+}
+
+struct ipc_comp_dev *ipc_get_comp_type(struct ipc *ipc, uint16_t type,
+	uint32_t id)
 {
 	struct ipc_comp_dev *icd;
 	struct list_item *clist;
 
-	list_for_item(clist, &ipc->comp_list) {
-		icd = container_of(clist, struct ipc_comp_dev, list);
-		switch (icd->type) {
-		case COMP_TYPE_COMPONENT:
-			if (icd->cd->comp.id == id)
-				return icd;
-			break;
-		case COMP_TYPE_BUFFER:
-			if (icd->cb->ipc_buffer.comp.id == id)
-				return icd;
+	if (type < COMP_TYPE_COMPONENT || type > COMP_TYPE_COUNT)
+		return NULL;
+
+	list_for_item(clist, ipc_comp_bucket(ipc, type, id)) {
+		icd = container_of(clist, struct ipc_comp_dev, hash_list);
+		if (icd->id == id)
+			return icd;
+	}
+
+	return NULL;
+}
+
+/* search all namespaces, used when the caller doesn't know the type */
+struct ipc_comp_dev *ipc_get_comp(struct ipc *ipc, uint32_t id)
+{
+	struct ipc_comp_dev *icd;
+	uint16_t type;
+
+	for (type = COMP_TYPE_COMPONENT; type <= COMP_TYPE_COUNT; type++) {
+		icd = ipc_get_comp_type(ipc, type, id);
+		if (icd != NULL)
+			return icd;
+	}
+
+	return NULL;
+}
+
+/*
+ * Topology snapshot. Each IPC message that built the graph is kept in order
+ * with the last value of each control, so the graph can be saved with the
+ * PM context and rebuilt in the DSP after resume. Records are dropped when
+ * an object they use is freed.
+ */
+
+static struct ipc_snap_rec *ipc_snap_add(struct ipc *ipc, uint32_t cmd,
+	void *msg, uint32_t size, uint16_t type, uint32_t id)
+{
+	struct ipc_snap_rec *rec;
+	struct sof_ipc_hdr *hdr;
+	uint32_t pad_size = (size + 3) & ~0x3;
+
+	/* restore runs each message from comp_data */
+	if (size < sizeof(*hdr) || pad_size > SOF_IPC_MSG_MAX_SIZE) {
+		trace_ipc_error("eNs");
+		trace_value(cmd);
+		ipc->snap_invalid = 1;
+		return NULL;
+	}
+
+	rec = rzalloc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*rec) + pad_size);
+	if (rec == NULL) {
+		trace_ipc_error("eNa");
+		ipc->snap_invalid = 1;
+		return NULL;
+	}
+
+	/* zero padded so every message in the snapshot stays word aligned */
+	rmemcpy(rec->msg, msg, size);
+	hdr = (struct sof_ipc_hdr *)rec->msg;
+	hdr->cmd = cmd;
+	hdr->size = pad_size;
+	rec->dep_type[0] = type;
+	rec->dep_id[0] = id;
+
+	list_item_append(&rec->list, &ipc->snap_list);
+	ipc->snap_count++;
+	ipc->snap_bytes += pad_size;
+	return rec;
+}
+
+static void ipc_snap_del(struct ipc *ipc, struct ipc_snap_rec *rec)
+{
+	struct sof_ipc_hdr *hdr = (struct sof_ipc_hdr *)rec->msg;
+
+	ipc->snap_count--;
+	ipc->snap_bytes -= hdr->size;
+	list_item_del(&rec->list);
+	rfree(rec);
+}
+
+/* drop every record that uses a freed object */
+static void ipc_snap_free(struct ipc *ipc, uint16_t type, uint32_t id)
+{
+	struct ipc_snap_rec *rec;
+	struct list_item *rlist, *tlist;
+
+	list_for_item_safe(rlist, tlist, &ipc->snap_list) {
+		rec = container_of(rlist, struct ipc_snap_rec, list);
+		if ((rec->dep_type[0] == type && rec->dep_id[0] == id) ||
+			(rec->dep_type[1] == type && rec->dep_id[1] == id))
+			ipc_snap_del(ipc, rec);
+	}
+}
+
+/* keep the last control set, single element sets are kept per element */
+void ipc_snap_ctrl(struct ipc *ipc, uint32_t cmd,
+	struct sof_ipc_ctrl_data *data)
+{
+	struct ipc_snap_rec *rec;
+	struct list_item *rlist, *tlist;
+	uint32_t key = data->type | data->cmd << 8;
+
+	if (data->num_elems == 1) {
+		switch (data->type) {
+		case SOF_CTRL_TYPE_VALUE_CHAN_SET:
+			key |= (data->chanv[0].channel + 1) << 16;
 			break;
-		case COMP_TYPE_PIPELINE:
-			if (icd->pipeline->ipc_pipe.comp_id == id)
-				return icd;
+		case SOF_CTRL_TYPE_VALUE_COMP_SET:
+			key |= (data->compv[0].index + 1) << 16;
 			break;
 		default:
 			break;
 		}
 	}
 
-	return NULL;
+	/* later set replaces any earlier one */
+	list_for_item_safe(rlist, tlist, &ipc->snap_list) {
+		rec = container_of(rlist, struct ipc_snap_rec, list);
+		if (rec->key == key && rec->dep_type[0] == COMP_TYPE_COMPONENT &&
+			rec->dep_id[0] == data->comp_id) {
+			ipc_snap_del(ipc, rec);
+			break;
+		}
+	}
+
+	rec = ipc_snap_add(ipc, cmd, data, data->rhdr.hdr.size,
+		COMP_TYPE_COMPONENT, data->comp_id);
+	if (rec != NULL)
+		rec->key = key;
+}
+
+/* keep the last config of each DAI, it's applied to DAI comps made before */
+static void ipc_snap_dai(struct ipc *ipc, struct sof_ipc_dai_config *config)
+{
+	struct ipc_snap_rec *rec;
+	struct list_item *rlist, *tlist;
+	uint32_t cmd = SOF_IPC_GLB_DAI_MSG | SOF_IPC_DAI_CONFIG;
+	uint32_t key = config->type << 16 | config->id;
+
+	list_for_item_safe(rlist, tlist, &ipc->snap_list) {
+		rec = container_of(rlist, struct ipc_snap_rec, list);
+		if (rec->msg[0] == cmd && rec->key == key) {
+			ipc_snap_del(ipc, rec);
+			break;
+		}
+	}
+
+	rec = ipc_snap_add(ipc, cmd, config, config->hdr.size, 0, 0);
+	if (rec != NULL)
+		rec->key = key;
+}
+
+/* size of snapshot or 0 if there is no usable snapshot */
+uint32_t ipc_snap_size(struct ipc *ipc)
+{
+	struct ipc_snap_rec *rec;
+	struct list_item *rlist;
+	uint32_t size, type = 0;
+	uint32_t glb;
+
+	if (ipc->snap_invalid || ipc->snap_count == 0)
+		return 0;
+
+	/* records are padded to words, restore rejects unaligned sizes */
+	size = sizeof(struct sof_ipc_pm_snap) + ipc->snap_bytes +
+		sizeof(struct sof_ipc_compound_hdr);
+
+	/* messages of the same type share a compound block */
+	list_for_item(rlist, &ipc->snap_list) {
+		rec = container_of(rlist, struct ipc_snap_rec, list);
+		glb = rec->msg[0] & SOF_GLB_TYPE_MASK;
+		if (glb != type) {
+			size += sizeof(struct sof_ipc_compound_hdr);
+			type = glb;
+		}
+	}
+
+	return size;
+}
+
+/* serialise snapshot into data, returns bytes written */
+int ipc_snap_write(struct ipc *ipc, void *data, uint32_t size)
+{
+	struct sof_ipc_compound_hdr block;
+	struct sof_ipc_pm_snap snap;
+	struct ipc_snap_rec *rec;
+	struct list_item *rlist;
+	struct sof_ipc_hdr *hdr;
+	uint8_t *dest = data;
+	uint32_t block_offset = 0;
+	uint32_t offset = sizeof(snap);
+
+	snap.magic = SOF_IPC_PM_SNAP_MAGIC;
+	snap.size = ipc_snap_size(ipc);
+	snap.count = ipc->snap_count;
+	snap.reserved = 0;
+	if (snap.size == 0 || snap.size > size) {
+		trace_ipc_error("eNw");
+		return -EINVAL;
+	}
+
+	block.hdr.size = sizeof(block);
+	block.hdr.cmd = 0;
+	block.count = 0;
+
+	list_for_item(rlist, &ipc->snap_list) {
+		rec = container_of(rlist, struct ipc_snap_rec, list);
+		hdr = (struct sof_ipc_hdr *)rec->msg;
+
+		/* close current block and start a new one on type change */
+		if ((hdr->cmd & SOF_GLB_TYPE_MASK) != block.hdr.cmd) {
+			if (block.count)
+				rmemcpy(dest + block_offset, &block,
+					sizeof(block));
+			block.hdr.cmd = hdr->cmd & SOF_GLB_TYPE_MASK;
+			block.count = 0;
+			block_offset = offset;
+			offset += sizeof(block);
+		}
+
+		rmemcpy(dest + offset, rec->msg, hdr->size);
+		offset += hdr->size;
+		block.count++;
+	}
+	rmemcpy(dest + block_offset, &block, sizeof(block));
+
+	/* end of sequence */
+	block.hdr.cmd = 0;
+	block.count = 0;
+	rmemcpy(dest + offset, &block, sizeof(block));
+
+	rmemcpy(dest, &snap, sizeof(snap));
+	return snap.size;
 }
 
 int ipc_comp_new(struct ipc *ipc, struct sof_ipc_comp *comp)
@@ -84,7 +322,7 @@ int ipc_comp_new(struct ipc *ipc, struct sof_ipc_comp *comp)
 	int ret = 0;
 
 	/* check whether component already exists */
-	icd = ipc_get_comp(ipc, comp->id);
+	icd = ipc_get_comp_type(ipc, COMP_TYPE_COMPONENT, comp->id);
 	if (icd != NULL) {
 		trace_ipc_error("eCe");
 		trace_value(comp->id);
@@ -106,10 +344,11 @@ int ipc_comp_new(struct ipc *ipc, struct sof_ipc_comp *comp)
 		return -ENOMEM;
 	}
 	icd->cd = cd;
-	icd->type = COMP_TYPE_COMPONENT;
 
 	/* add new component to the list */
-	list_item_append(&icd->list, &ipc->comp_list);
+	ipc_comp_add(ipc, icd, COMP_TYPE_COMPONENT, comp->id);
+	ipc_snap_add(ipc, SOF_IPC_GLB_TPLG_MSG | SOF_IPC_TPLG_COMP_NEW, comp,
+		comp->hdr.size, COMP_TYPE_COMPONENT, comp->id);
 	return ret;
 }
 
@@ -118,14 +357,15 @@ int ipc_comp_free(struct ipc *ipc, uint32_t comp_id)
 	struct ipc_comp_dev *icd;
 
 	/* check whether component exists */
-	icd = ipc_get_comp(ipc, comp_id);
+	icd = ipc_get_comp_type(ipc, COMP_TYPE_COMPONENT, comp_id);
 	if (icd == NULL)
 		return -ENODEV;
 
 	/* free component and remove from list */
 	comp_free(icd->cd);
-	list_item_del(&icd->list);
+	ipc_comp_del(icd);
 	rfree(icd);
+	ipc_snap_free(ipc, COMP_TYPE_COMPONENT, comp_id);
 
 	return 0;
 }
@@ -137,7 +377,7 @@ int ipc_buffer_new(struct ipc *ipc, struct sof_ipc_buffer *desc)
 	int ret = 0;
 
 	/* check whether buffer already exists */
-	ibd = ipc_get_comp(ipc, desc->comp.id);
+	ibd = ipc_get_comp_type(ipc, COMP_TYPE_BUFFER, desc->comp.id);
 	if (ibd != NULL) {
 		trace_ipc_error("eBe");
 		trace_value(desc->comp.id);
@@ -158,10 +398,11 @@ int ipc_buffer_new(struct ipc *ipc, struct sof_ipc_buffer *desc)
 		return -ENOMEM;
 	}
 	ibd->cb = buffer;
-	ibd->type = COMP_TYPE_BUFFER;
 
 	/* add new buffer to the list */
-	list_item_append(&ibd->list, &ipc->comp_list);
+	ipc_comp_add(ipc, ibd, COMP_TYPE_BUFFER, desc->comp.id);
+	ipc_snap_add(ipc, SOF_IPC_GLB_TPLG_MSG | SOF_IPC_TPLG_BUFFER_NEW, desc,
+		desc->comp.hdr.size, COMP_TYPE_BUFFER, desc->comp.id);
 	return ret;
 }
 
@@ -170,14 +411,15 @@ int ipc_buffer_free(struct ipc *ipc, uint32_t buffer_id)
 	struct ipc_comp_dev *ibd;
 
 	/* check whether buffer exists */
-	ibd = ipc_get_comp(ipc, buffer_id);
+	ibd = ipc_get_comp_type(ipc, COMP_TYPE_BUFFER, buffer_id);
 	if (ibd == NULL)
 		return -ENODEV;
 
 	/* free buffer and remove from list */
 	buffer_free(ibd->cb);
-	list_item_del(&ibd->list);
+	ipc_comp_del(ibd);
 	rfree(ibd);
+	ipc_snap_free(ipc, COMP_TYPE_BUFFER, buffer_id);
 
 	return 0;
 }
@@ -186,37 +428,64 @@ int ipc_comp_connect(struct ipc *ipc,
 	struct sof_ipc_pipe_comp_connect *connect)
 {
 	struct ipc_comp_dev *icd_source, *icd_sink;
+	struct ipc_snap_rec *rec;
+	int ret;
 
-	/* check whether the components already exist */
-	icd_source = ipc_get_comp(ipc, connect->source_id);
-	if (icd_source == NULL) {
-		trace_ipc_error("eCr");
-		trace_value(connect->source_id);
-		return -EINVAL;
+	/* component -> buffer, IDs are looked up in each namespace */
+	icd_source = ipc_get_comp_type(ipc, COMP_TYPE_COMPONENT,
+		connect->source_id);
+	icd_sink = ipc_get_comp_type(ipc, COMP_TYPE_BUFFER, connect->sink_id);
+	if (icd_source != NULL && icd_sink != NULL) {
+		ret = pipeline_comp_connect(icd_source->pipeline,
+			icd_source->cd, icd_sink->cb);
+		if (ret < 0)
+			return ret;
+
+		rec = ipc_snap_add(ipc, SOF_IPC_GLB_TPLG_MSG |
+			SOF_IPC_TPLG_COMP_CONNECT, connect, sizeof(*connect),
+			COMP_TYPE_COMPONENT, connect->source_id);
+		if (rec != NULL) {
+			rec->dep_type[1] = COMP_TYPE_BUFFER;
+			rec->dep_id[1] = connect->sink_id;
+		}
+		return ret;
 	}
 
-	icd_sink = ipc_get_comp(ipc, connect->sink_id);
-	if (icd_sink == NULL) {
-		trace_ipc_error("eCn");
-		trace_value(connect->sink_id);
-		return -EINVAL;
+	/* buffer -> component */
+	icd_source = ipc_get_comp_type(ipc, COMP_TYPE_BUFFER,
+		connect->source_id);
+	icd_sink = ipc_get_comp_type(ipc, COMP_TYPE_COMPONENT,
+		connect->sink_id);
+	if (icd_source != NULL && icd_sink != NULL) {
+		ret = pipeline_buffer_connect(icd_source->pipeline,
+			icd_source->cb, icd_sink->cd);
+		if (ret < 0)
+			return ret;
+
+		rec = ipc_snap_add(ipc, SOF_IPC_GLB_TPLG_MSG |
+			SOF_IPC_TPLG_COMP_CONNECT, connect, sizeof(*connect),
+			COMP_TYPE_BUFFER, connect->source_id);
+		if (rec != NULL) {
+			rec->dep_type[1] = COMP_TYPE_COMPONENT;
+			rec->dep_id[1] = connect->sink_id;
+		}
+		return ret;
 	}
 
-	/* check source and sink types */
-	if (icd_source->type == COMP_TYPE_BUFFER &&
-		icd_sink->type == COMP_TYPE_COMPONENT)
-		return pipeline_buffer_connect(icd_source->pipeline,
-			icd_source->cb, icd_sink->cd);
-	else if (icd_source->type == COMP_TYPE_COMPONENT &&
-		icd_sink->type == COMP_TYPE_BUFFER)
-		return pipeline_comp_connect(icd_source->pipeline,
-			icd_source->cd, icd_sink->cb);
-	else {
+	/* report which end is missing or has the wrong type */
+	if (ipc_get_comp(ipc, connect->source_id) == NULL) {
+		trace_ipc_error("eCr");
+		trace_value(connect->source_id);
+	} else if (ipc_get_comp(ipc, connect->sink_id) == NULL) {
+		trace_ipc_error("eCn");
+		trace_value(connect->sink_id);
+	} else {
 		trace_ipc_error("eCt");
 		trace_value(connect->source_id);
 		trace_value(connect->sink_id);
-		return -EINVAL;
 	}
+
+	return -EINVAL;
 }
 
 
@@ -226,9 +495,11 @@ int ipc_pipeline_new(struct ipc *ipc,
 	struct ipc_comp_dev *ipc_pipe;
 	struct pipeline *pipe;
 	struct ipc_comp_dev *icd;
+	struct ipc_snap_rec *rec;
 
 	/* check whether the pipeline already exists */
-	ipc_pipe = ipc_get_comp(ipc, pipe_desc->comp_id);
+	ipc_pipe = ipc_get_comp_type(ipc, COMP_TYPE_PIPELINE,
+		pipe_desc->comp_id);
 	if (ipc_pipe != NULL) {
 		trace_ipc_error("ePi");
 		trace_value(pipe_desc->comp_id);
@@ -236,16 +507,12 @@ int ipc_pipeline_new(struct ipc *ipc,
 	}
 
 	/* find the scheduling component */
-	icd = ipc_get_comp(ipc, pipe_desc->sched_id);
+	icd = ipc_get_comp_type(ipc, COMP_TYPE_COMPONENT, pipe_desc->sched_id);
 	if (icd == NULL) {
 		trace_ipc_error("ePs");
 		trace_value(pipe_desc->sched_id);
 		return -EINVAL;
 	}
-	if (icd->type != COMP_TYPE_COMPONENT) {
-		trace_ipc_error("ePc");
-		return -EINVAL;
-	}
 
 	/* create the pipeline */
 	pipe = pipeline_new(pipe_desc, icd->cd);
@@ -263,10 +530,17 @@ int ipc_pipeline_new(struct ipc *ipc,
 	}
 
 	ipc_pipe->pipeline = pipe;
-	ipc_pipe->type = COMP_TYPE_PIPELINE;
 
 	/* add new pipeline to the list */
-	list_item_append(&ipc_pipe->list, &ipc->comp_list);
+	ipc_comp_add(ipc, ipc_pipe, COMP_TYPE_PIPELINE, pipe_desc->comp_id);
+
+	rec = ipc_snap_add(ipc, SOF_IPC_GLB_TPLG_MSG | SOF_IPC_TPLG_PIPE_NEW,
+		pipe_desc, sizeof(*pipe_desc), COMP_TYPE_PIPELINE,
+		pipe_desc->comp_id);
+	if (rec != NULL) {
+		rec->dep_type[1] = COMP_TYPE_COMPONENT;
+		rec->dep_id[1] = pipe_desc->sched_id;
+	}
 	return 0;
 }
 
@@ -276,7 +550,7 @@ int ipc_pipeline_free(struct ipc *ipc, uint32_t comp_id)
 	int ret;
 
 	/* check whether pipeline exists */
-	ipc_pipe = ipc_get_comp(ipc, comp_id);
+	ipc_pipe = ipc_get_comp_type(ipc, COMP_TYPE_PIPELINE, comp_id);
 	if (ipc_pipe == NULL)
 		return -ENODEV;
 
@@ -287,8 +561,9 @@ int ipc_pipeline_free(struct ipc *ipc, uint32_t comp_id)
 		return ret;
 	}
 
-	list_item_del(&ipc_pipe->list);
+	ipc_comp_del(ipc_pipe);
 	rfree(ipc_pipe);
+	ipc_snap_free(ipc, COMP_TYPE_PIPELINE, comp_id);
 
 	return 0;
 }
@@ -296,14 +571,19 @@ int ipc_pipeline_free(struct ipc *ipc, uint32_t comp_id)
 void ipc_pipeline_complete(struct ipc *ipc, uint32_t comp_id)
 {
 	struct ipc_comp_dev *ipc_pipe;
+	struct sof_ipc_pipe_ready ready;
 
 	/* check whether pipeline exists */
-	ipc_pipe = ipc_get_comp(ipc, comp_id);
+	ipc_pipe = ipc_get_comp_type(ipc, COMP_TYPE_PIPELINE, comp_id);
 	if (ipc_pipe == NULL)
 		return;
 
 	/* free buffer and remove from list */
 	pipeline_complete(ipc_pipe->pipeline);
+
+	ready.comp_id = comp_id;
+	ipc_snap_add(ipc, SOF_IPC_GLB_TPLG_MSG | SOF_IPC_TPLG_PIPE_COMPLETE,
+		&ready, sizeof(ready), COMP_TYPE_PIPELINE, comp_id);
 }
 
 int ipc_comp_dai_config(struct ipc *ipc, struct sof_ipc_dai_config *config)
@@ -339,11 +619,35 @@ int ipc_comp_dai_config(struct ipc *ipc, struct sof_ipc_dai_config *config)
 		}
 	}
 
+	ipc_snap_dai(ipc, config);
 	return ret;
 }
 
+/*
+ * Host commands and DSP notifications are run by a task at the lowest task
+ * priority so audio pipeline tasks and their deadlines always preempt them.
+ */
+static void ipc_process_task(void *data)
+{
+	struct ipc *ipc = data;
+
+	/* blocking command is being run by the idle loop */
+	if ((ipc->host_pending || ipc->rx_pending) && !ipc->idle_pending)
+		ipc_platform_do_cmd(ipc);
+	if (ipc->dsp_pending)
+		ipc_platform_send_msg(ipc);
+}
+
+/* queue IPC task, if it's running it's queued again when it completes */
+void ipc_schedule_process(struct ipc *ipc)
+{
+	schedule_task(&ipc->ipc_task, 0, PLATFORM_IPC_DEADLINE);
+}
+
 int ipc_init(struct reef *reef)
 {
+	int i, j;
+
 	trace_ipc("IPI");
 
 	/* init ipc data */
@@ -351,6 +655,14 @@ int ipc_init(struct reef *reef)
 	reef->ipc->comp_data = rzalloc(RZONE_SYS, RFLAGS_NONE, SOF_IPC_MSG_MAX_SIZE);
 
 	list_init(&reef->ipc->comp_list);
+	list_init(&reef->ipc->snap_list);
+	schedule_task_init(&reef->ipc->ipc_task, ipc_process_task, reef->ipc);
+	schedule_task_config(&reef->ipc->ipc_task, TASK_PRI_LOW, 0);
+	reef->ipc->ipc_task.id = TRACE_MARK_TASK_IPC;
+	for (i = 0; i < COMP_TYPE_COUNT; i++) {
+		for (j = 0; j < IPC_COMP_HASH_SIZE; j++)
+			list_init(&reef->ipc->comp_hash[i][j]);
+	}
 
 	return platform_ipc_init(reef->ipc);
 }
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * DSP load accounting.
+ *
+ * Busy time is measured in frames around task, work queue and pipeline
+ * runs. Frames nest as IRQs preempt each other and a frame only counts its
+ * own time, nested frames are removed. Idle time is the time the main loop
+ * spends in WAITI less the busy frames that ran in it, time in untracked IRQ
+ * handlers is counted as idle.
+ *
+ * Every window the busy time of each registered window gives its load and
+ * the idle time gives the total DSP load. Peaks are held until the host
+ * resets them.
+ */
+
+#include <stdint.h>
+#include <reef/reef.h>
+#include <reef/lock.h>
+#include <reef/list.h>
+#include <reef/work.h>
+#include <reef/trace.h>
+#include <reef/load.h>
+#include <platform/timer.h>
+#include <uapi/ipc.h>
+
+struct load_data {
+	spinlock_t lock;
+	struct list_item windows;	/* registered load windows */
+	struct work work;
+	uint32_t window_start;
+	uint32_t window_ticks;		/* length of last window */
+
+	/* busy frames */
+	uint32_t depth;
+	uint32_t child;			/* ticks of frames in current frame */
+	uint32_t busy;			/* ticks of outermost frames */
+
+	/* idle */
+	uint32_t in_idle;
+	uint32_t idle_start;
+	uint32_t idle_busy;		/* busy at idle start */
+	uint32_t idle;			/* idle ticks in current window */
+
+	uint32_t load;			/* total load of last window */
+	uint32_t peak;
+};
+
+/* tracing */
+#define trace_load(__e)	trace_event(TRACE_CLASS_PIPE, __e)
+
+static struct load_data load;
+
+void load_frame_begin(struct load_frame *frame)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&load.lock, flags);
+
+	frame->start = platform_timer_get_low();
+	frame->child = load.child;
+	load.child = 0;
+	load.depth++;
+
+	spin_unlock_irq(&load.lock, flags);
+}
+
+/* returns frame ticks less nested frames */
+uint32_t load_frame_end(struct load_frame *frame, struct load_window *window)
+{
+	uint32_t elapsed, ticks;
+	uint32_t flags;
+
+	spin_lock_irq(&load.lock, flags);
+
+	elapsed = platform_timer_get_low() - frame->start;
+	ticks = elapsed - load.child;
+
+	if (window)
+		window->busy += ticks;
+
+	/* parent does not count our time */
+	load.child = frame->child + elapsed;
+
+	if (--load.depth == 0) {
+		load.busy += elapsed;
+		load.child = 0;
+	}
+
+	spin_unlock_irq(&load.lock, flags);
+	return ticks;
+}
+
+/* add idle time up to now, lock held by caller */
+static void load_idle_update(void)
+{
+	uint32_t now = platform_timer_get_low();
+	uint32_t ticks = now - load.idle_start;
+	uint32_t busy = load.busy - load.idle_busy;
+
+	/* a frame running at the last update can end up more than ticks */
+	if (ticks > busy)
+		load.idle += ticks - busy;
+	load.idle_start = now;
+	load.idle_busy = load.busy;
+}
+
+void load_idle_begin(void)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&load.lock, flags);
+
+	load.idle_start = platform_timer_get_low();
+	load.idle_busy = load.busy;
+	load.in_idle = 1;
+
+	spin_unlock_irq(&load.lock, flags);
+}
+
+void load_idle_end(void)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&load.lock, flags);
+
+	load_idle_update();
+	load.in_idle = 0;
+
+	spin_unlock_irq(&load.lock, flags);
+}
+
+static inline uint32_t load_scale(uint32_t ticks, uint32_t window)
+{
+	uint64_t scaled = (uint64_t)ticks * LOAD_SCALE;
+
+	if (ticks >= window)
+		return LOAD_SCALE;
+
+	return scaled / window;
+}
+
+/* close the window and start the next one */
+static uint32_t load_work(void *data, uint32_t delay)
+{
+	struct load_window *window;
+	struct list_item *item;
+	uint32_t flags;
+	uint32_t now;
+
+	spin_lock_irq(&load.lock, flags);
+
+	/* count idle time so far if the main loop is still in WAITI */
+	if (load.in_idle)
+		load_idle_update();
+
+	now = platform_timer_get_low();
+	load.window_ticks = now - load.window_start;
+	load.window_start = now;
+
+	load.load = LOAD_SCALE - load_scale(load.idle, load.window_ticks);
+	if (load.load > load.peak)
+		load.peak = load.load;
+	load.idle = 0;
+
+	list_for_item(item, &load.windows) {
+		window = container_of(item, struct load_window, list);
+
+		window->load = load_scale(window->busy, load.window_ticks);
+		if (window->load > window->peak)
+			window->peak = window->load;
+		window->busy = 0;
+	}
+
+	spin_unlock_irq(&load.lock, flags);
+
+	return LOAD_WINDOW_US;
+}
+
+void load_window_register(struct load_window *window, uint32_t id)
+{
+	uint32_t flags;
+
+	window->id = id;
+	window->busy = 0;
+	window->load = 0;
+	window->peak = 0;
+
+	spin_lock_irq(&load.lock, flags);
+	list_item_append(&window->list, &load.windows);
+	spin_unlock_irq(&load.lock, flags);
+}
+
+void load_window_unregister(struct load_window *window)
+{
+	uint32_t flags;
+
+	spin_lock_irq(&load.lock, flags);
+	list_item_del(&window->list);
+	spin_unlock_irq(&load.lock, flags);
+}
+
+void load_report(struct sof_ipc_trace_load_reply *reply, uint32_t reset_peak)
+{
+	struct load_window *window;
+	struct list_item *item;
+	uint32_t flags;
+	uint32_t i = 0;
+
+	spin_lock_irq(&load.lock, flags);
+
+	reply->window_ticks = load.window_ticks;
+	reply->load = load.load;
+	reply->peak = load.peak;
+	if (reset_peak)
+		load.peak = load.load;
+
+	list_for_item(item, &load.windows) {
+		window = container_of(item, struct load_window, list);
+
+		/* pipelines that do not fit are not reported */
+		if (i == SOF_IPC_LOAD_MAX_PIPES)
+			break;
+
+		reply->pipe[i].pipeline_id = window->id;
+		reply->pipe[i].load = window->load;
+		reply->pipe[i].peak = window->peak;
+		if (reset_peak)
+			window->peak = window->load;
+		i++;
+	}
+
+	reply->num_pipes = i;
+
+	spin_unlock_irq(&load.lock, flags);
+}
+
+void load_init(void)
+{
+	trace_load("LIn");
+
+	spinlock_init(&load.lock);
+	list_init(&load.windows);
+	load.window_start = platform_timer_get_low();
+
+	work_init(&load.work, load_work, NULL, WORK_ASYNC);
+	work_schedule_default(&load.work, LOAD_WINDOW_US);
+}
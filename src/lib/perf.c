@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * Code region performance reports. Stall cycles are estimated as the cycles
+ * that did not commit an instruction.
+ */
+
+#include <stdint.h>
+#include <reef/reef.h>
+#include <reef/trace.h>
+#include <reef/perf.h>
+
+#if PERF && defined(__XTENSA__)
+
+/* tracing */
+#define trace_perf(__e, __v0, __v1, __v2) \
+	trace_event_value3(TRACE_CLASS_PERF, __e, __v0, __v1, __v2)
+
+/* send averages per run since the last report and start a new report */
+void perf_region_report(struct perf_region *r)
+{
+	uint32_t avg[PERF_EVENTS];
+	uint32_t events = perf_events();
+	int i;
+
+	if (r->runs == 0)
+		return;
+
+	for (i = 0; i < PERF_EVENTS; i++)
+		avg[i] = r->total[i] / r->runs;
+
+	trace_perf("pfc", r->id, avg[PERF_CYCLES], r->max_cycles);
+
+	if (events & (1 << PERF_INSTR))
+		trace_perf("pfs", r->id, avg[PERF_INSTR],
+			avg[PERF_CYCLES] - avg[PERF_INSTR]);
+
+	if (events & ((1 << PERF_ICACHE_MISS) | (1 << PERF_DCACHE_MISS)))
+		trace_perf("pfm", r->id, avg[PERF_ICACHE_MISS],
+			avg[PERF_DCACHE_MISS]);
+
+	perf_region_init(r, r->id);
+}
+
+#endif
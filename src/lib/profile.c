@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * Statistical sampling profiler.
+ *
+ * A spare CPU timer interrupts at the sample rate and the PC it interrupted
+ * is counted in a hash table along with the current profile context, normally
+ * the component being copied. The table is sent to the host in the DMA trace
+ * as binary records from a work item and cleared every report period.
+ *
+ * Samples are taken at the profile timer IRQ level, code running with this
+ * level masked is counted at the first PC after it is unmasked.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <reef/reef.h>
+#include <reef/alloc.h>
+#include <reef/debug.h>
+#include <reef/trace.h>
+#include <reef/timer.h>
+#include <reef/interrupt.h>
+#include <reef/clock.h>
+#include <reef/work.h>
+#include <reef/profile.h>
+#include <reef/audio/dma-trace.h>
+#include <platform/platform.h>
+#include <platform/timer.h>
+#include <platform/clk.h>
+#include <uapi/trace.h>
+
+#if PROFILE
+
+/* tracing */
+#define trace_profile(__e)	trace_event(TRACE_CLASS_PROFILE, __e)
+#define trace_profile_error(__e)	trace_error(TRACE_CLASS_PROFILE, __e)
+
+/* sample table entries, must be a power of 2 */
+#define PROFILE_ENTRIES		256
+#define PROFILE_PROBES		8
+
+/* entries sent per trace record */
+#define PROFILE_RECORD_ENTRIES	32
+
+#define PROFILE_MAX_RATE_HZ	10000
+#define PROFILE_DEFAULT_REPORT_MS	1000
+
+struct profile_record {
+	struct trace_profile_hdr hdr;
+	struct trace_profile_entry entry[PROFILE_RECORD_ENTRIES];
+} __attribute__((packed));
+
+struct profile_data {
+	struct timer timer;
+	struct work work;
+	uint32_t period;	/* CPU cycles between samples */
+	uint32_t compare;	/* CPU cycle count of next sample */
+	uint32_t report_us;
+	uint32_t samples;
+	uint32_t dropped;
+	uint32_t running;
+	struct trace_profile_entry *table;
+	struct profile_record record;
+};
+
+volatile uint32_t profile_ctx = TRACE_PROFILE_CTX_NONE;
+
+static struct profile_data *profile = NULL;
+
+static inline uint32_t profile_hash(uint32_t pc, uint32_t ctx)
+{
+	return ((pc >> 2) ^ (pc >> 10) ^ ctx) & (PROFILE_ENTRIES - 1);
+}
+
+static void profile_irq(void *arg)
+{
+	struct profile_data *p = arg;
+	struct trace_profile_entry *e;
+	uint32_t pc = interrupt_get_pc(PLATFORM_PROFILE_LEVEL);
+	uint32_t ctx = profile_ctx;
+	uint32_t hash = profile_hash(pc, ctx);
+	uint32_t now;
+	int i;
+
+	/* arm next sample, start again from now if samples were missed */
+	p->compare += p->period;
+	now = timer_get_cycles();
+	if ((int32_t)(p->compare - now) <= 0)
+		p->compare = now + p->period;
+	timer_set_compare(&p->timer, p->compare);
+
+	p->samples++;
+
+	for (i = 0; i < PROFILE_PROBES; i++) {
+		e = &p->table[(hash + i) & (PROFILE_ENTRIES - 1)];
+
+		if (e->count == 0) {
+			e->pc = pc;
+			e->ctx = ctx;
+		} else if (e->pc != pc || e->ctx != ctx)
+			continue;
+
+		e->count++;
+		return;
+	}
+
+	p->dropped++;
+}
+
+/* send the table to the host and clear it, sample IRQ must be off */
+static void profile_report(struct profile_data *p)
+{
+	struct profile_record *r = &p->record;
+	struct trace_profile_entry *e;
+	uint32_t count = 0;
+	int i;
+
+	r->hdr.magic = TRACE_PROFILE_MAGIC;
+	r->hdr.samples = 0;
+	r->hdr.dropped = 0;
+
+	for (i = 0; i < PROFILE_ENTRIES; i++) {
+		e = &p->table[i];
+		if (e->count == 0)
+			continue;
+
+		r->entry[count++] = *e;
+		e->count = 0;
+
+		if (count == PROFILE_RECORD_ENTRIES) {
+			r->hdr.count = count;
+			dtrace_data(r, sizeof(r->hdr) + count * sizeof(*e));
+			count = 0;
+		}
+	}
+
+	/* last record has the totals and is always sent */
+	r->hdr.count = count;
+	r->hdr.samples = p->samples;
+	r->hdr.dropped = p->dropped;
+	dtrace_data(r, sizeof(r->hdr) + count * sizeof(*e));
+
+	p->samples = 0;
+	p->dropped = 0;
+}
+
+static uint32_t profile_work(void *data, uint32_t delay)
+{
+	struct profile_data *p = data;
+
+	timer_disable(&p->timer);
+	profile_report(p);
+	timer_enable(&p->timer);
+
+	return p->report_us;
+}
+
+int profile_start(uint32_t rate_hz, uint32_t report_ms)
+{
+	struct profile_data *p = profile;
+
+	trace_profile("PSt");
+
+	if (rate_hz == 0 || rate_hz > PROFILE_MAX_RATE_HZ) {
+		trace_profile_error("ePr");
+		trace_value(rate_hz);
+		return -EINVAL;
+	}
+
+	if (p == NULL) {
+		p = rzalloc(RZONE_RUNTIME, RFLAGS_NONE, sizeof(*p));
+		if (p == NULL) {
+			trace_profile_error("ePa");
+			return -ENOMEM;
+		}
+
+		p->table = rballoc(RZONE_RUNTIME, RFLAGS_NONE,
+			PROFILE_ENTRIES * sizeof(*p->table));
+		if (p->table == NULL) {
+			trace_profile_error("ePt");
+			rfree(p);
+			return -ENOMEM;
+		}
+
+		p->timer.id = PLATFORM_PROFILE_TIMER;
+		p->timer.irq = PLATFORM_PROFILE_TIMER;
+		work_init(&p->work, profile_work, p, WORK_ASYNC);
+		interrupt_register(p->timer.irq, profile_irq, p);
+		profile = p;
+	}
+
+	/* restart with new settings */
+	if (p->running)
+		profile_stop();
+
+	if (report_ms == 0)
+		report_ms = PROFILE_DEFAULT_REPORT_MS;
+
+	bzero(p->table, PROFILE_ENTRIES * sizeof(*p->table));
+	p->samples = 0;
+	p->dropped = 0;
+	p->report_us = report_ms * 1000;
+
+	/* CPU clock can change, so period is only valid for this run */
+	p->period = clock_get_freq(CLK_CPU) / rate_hz;
+	p->compare = timer_get_cycles() + p->period;
+	timer_set_compare(&p->timer, p->compare);
+	timer_enable(&p->timer);
+
+	p->running = 1;
+	work_schedule_default(&p->work, p->report_us);
+	return 0;
+}
+
+void profile_stop(void)
+{
+	struct profile_data *p = profile;
+
+	trace_profile("PSp");
+
+	if (p == NULL || !p->running)
+		return;
+
+	timer_disable(&p->timer);
+	work_cancel_default(&p->work);
+
+	/* send samples since the last report */
+	profile_report(p);
+	p->running = 0;
+}
+
+#endif
@@ -187,8 +187,14 @@ struct task *schedule_edf(void)
 		/* yes, get next task and run this one now */
 		next_plus1_task = edf_get_next(current, task);
 
-		/* run current task */
+		/* run current task, it's not picked again until complete */
+		spin_lock_irq(&sch->lock, flags);
 		task->start = current;
+		task->state = TASK_STATE_RUNNING;
+		spin_unlock_irq(&sch->lock, flags);
+
+		trace_mark2(TRACE_MARK_TASK_RUN, task->id,
+			(uint32_t)task->deadline);
 		arch_run_task(task);
 	}
 
@@ -208,7 +214,8 @@ int schedule_task_del(struct task *task)
 	spin_lock_irq(&sch->lock, flags);
 
 	/* is task already running ? */
-	if (task->state == TASK_STATE_RUNNING) {
+	if (task->state == TASK_STATE_RUNNING ||
+		task->state == TASK_STATE_RERUN) {
 		ret = -EAGAIN;
 		goto out;
 	}
@@ -222,14 +229,11 @@ out:
 }
 
 /*
- * Add a new task to the scheduler to be run and define a scheduling
- * window in time for the task to be ran. i.e. task will run between start and
- * deadline times.
- *
- * start is in microseconds relative to last task start time.
- * deadline is in microseconds relative to start.
+ * Add a new task to the scheduler list without running the scheduler.
+ * Returns 0 if task was queued or -EBUSY if it's running, in which case it's
+ * queued again when it completes.
  */
-void schedule_task(struct task *task, uint64_t start, uint64_t deadline)
+static int schedule_task_queue(struct task *task, uint64_t start, uint64_t deadline)
 {
 	uint32_t flags;
 	uint64_t current;
@@ -238,11 +242,11 @@ void schedule_task(struct task *task, uint64_t start, uint64_t deadline)
 
 	spin_lock_irq(&sch->lock, flags);
 
-	/* is task already running ? - not enough MIPS to complete ? */
-	if (task->state == TASK_STATE_RUNNING) {
-		trace_pipe("tsk");
+	/* already queued - keep current window, list can't hold it twice */
+	if (task->state == TASK_STATE_QUEUED ||
+		task->state == TASK_STATE_RERUN) {
 		spin_unlock_irq(&sch->lock, flags);
-		return;
+		return 0;
 	}
 
 	/* get the current time */
@@ -258,26 +262,60 @@ void schedule_task(struct task *task, uint64_t start, uint64_t deadline)
 	/* calculate deadline - TODO: include MIPS */
 	task->deadline = task->start + clock_us_to_ticks(sch->clock, deadline);
 
+	/* is task already running ? - queue it again when it completes */
+	if (task->state == TASK_STATE_RUNNING) {
+		trace_pipe("tsk");
+		task->state = TASK_STATE_RERUN;
+		spin_unlock_irq(&sch->lock, flags);
+		return -EBUSY;
+	}
+
 	/* add task to list */
 	list_item_append(&task->list, &sch->list);
 	task->state = TASK_STATE_QUEUED;
 	spin_unlock_irq(&sch->lock, flags);
 
+	trace_mark2(TRACE_MARK_TASK_QUEUE, task->id, (uint32_t)task->deadline);
+
+	return 0;
+}
+
+/*
+ * Add a new task to the scheduler to be run and define a scheduling
+ * window in time for the task to be ran. i.e. task will run between start and
+ * deadline times.
+ *
+ * start is in microseconds relative to last task start time.
+ * deadline is in microseconds relative to start.
+ */
+void schedule_task(struct task *task, uint64_t start, uint64_t deadline)
+{
 	/* rerun scheduler */
-	schedule();
+	if (schedule_task_queue(task, start, deadline) == 0)
+		schedule();
 }
 
-/* Remove a task from the scheduler when complete */
+/* Remove a task from the scheduler when complete unless queued again */
 void schedule_task_complete(struct task *task)
 {
 	uint32_t flags;
+	int rerun = 0;
 
 	tracev_pipe("com");
 
 	spin_lock_irq(&sch->lock, flags);
-	list_item_del(&task->list);
-	task->state = TASK_STATE_COMPLETED;
+	if (task->state == TASK_STATE_RERUN) {
+		/* still in list, run it in the window set when queued */
+		task->state = TASK_STATE_QUEUED;
+		rerun = 1;
+	} else {
+		list_item_del(&task->list);
+		task->state = TASK_STATE_COMPLETED;
+	}
 	spin_unlock_irq(&sch->lock, flags);
+
+	if (rerun)
+		schedule();
 }
 
 void scheduler_run(void *unused)
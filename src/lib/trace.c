@@ -31,43 +31,156 @@
 #include <reef/trace.h>
 #include <reef/reef.h>
 #include <reef/alloc.h>
+#include <reef/atomic.h>
 #include <arch/cache.h>
 #include <platform/timer.h>
-#include <reef/lock.h>
 #include <stdint.h>
 
+/*
+ * Compact trace ring in the mailbox trace region, see uapi/trace.h for the
+ * record format. Writers reserve a record with an atomic bump of the ring
+ * position so no lock or IRQ masking is needed, an IRQ that preempts a
+ * writer just takes the next record. The timestamp is read inside the
+ * reservation loop so records are always in time order.
+ *
+ * The writer that starts block N clears block N + 2 once its reservation
+ * has succeeded. Block N + 1 was cleared the same way when block N - 1 was
+ * started, so readers always find the end of block N, and a block is only
+ * cleared while it is still more than one block ahead of the writers. The
+ * block before N is written back at the same time.
+ * Entries in the current block are written back by trace_flush().
+ *
+ * BYT and CHT have one core, another core would get its own ring.
+ */
+
+#define TRACE_WORD		sizeof(uint32_t)
+#define TRACE_SYNC_SIZE		(TRACE_WORD << 1)
+#define TRACE_BLOCK_MASK	(TRACE_BLOCK_SIZE - 1)
+
+/* blocks N to N + 2 must be distinct */
+#if MAILBOX_TRACE_SIZE < 3 * TRACE_BLOCK_SIZE
+#error Trace ring needs at least 3 blocks
+#endif
+
 struct trace {
-	uint32_t pos ;	/* trace position */
+	atomic_t pos;	/* next record offset in ring */
+	uint32_t last;	/* timestamp of the last record */
 	uint32_t enable;
-	spinlock_t lock;
 };
 
 static struct trace trace;
 
-void _trace_event(uint32_t event)
+/* dictionary head, keeps event ID 0 free for the block end marker */
+static const struct trace_dict_entry trace_dict_head
+	__attribute__((section(".trace_dict.head"), used)) = {
+	.code = "trc",
+	.file = "",
+};
+
+/* enabled classes per level, verbose, markers and perf regions are off
+ * until the host asks for them */
+uint32_t trace_mask[TRACE_LEVELS] = {
+	[TRACE_LEVEL_ERROR] = 0xffffffff,
+	[TRACE_LEVEL_NORMAL] = ~(TRACE_CLASS_BIT(TRACE_CLASS_MARK) |
+		TRACE_CLASS_BIT(TRACE_CLASS_PERF)),
+	[TRACE_LEVEL_VERBOSE] = 0,
+};
+
+/* ring offset of the block after the block at offset */
+static inline uint32_t trace_block_next(uint32_t offset)
+{
+	offset = (offset & ~TRACE_BLOCK_MASK) + TRACE_BLOCK_SIZE;
+	return offset >= MAILBOX_TRACE_SIZE ? 0 : offset;
+}
+
+/* new block at offset - clear the block after the next one */
+static void trace_block_clear(uint32_t offset)
+{
+	uint32_t *clear;
+	int i;
+
+	clear = (uint32_t *)(MAILBOX_TRACE_BASE +
+		trace_block_next(trace_block_next(offset)));
+	for (i = 0; i < TRACE_BLOCK_SIZE / TRACE_WORD; i++)
+		clear[i] = 0;
+	dcache_writeback_region(clear, TRACE_BLOCK_SIZE);
+}
+
+/* new block at offset - writeback the last one */
+static void trace_block_done(uint32_t offset)
+{
+	uint32_t last;
+
+	last = offset ? offset : MAILBOX_TRACE_SIZE;
+	dcache_writeback_region((void *)(MAILBOX_TRACE_BASE + last -
+		TRACE_BLOCK_SIZE), TRACE_BLOCK_SIZE);
+}
+
+void _trace_event(uint32_t id, uint32_t argc, uint32_t a0, uint32_t a1,
+	uint32_t a2)
 {
-	unsigned long flags;
 	volatile uint32_t *t;
+	uint32_t pos, start, next, size, ts;
+	int sync;
 
 	if (!trace.enable)
 		return;
 
-	spin_lock_irq(&trace.lock, flags);
+	/* reserve record, retry if we were preempted by another writer */
+	do {
+		ts = platform_timer_get_low();
+		pos = atomic_read(&trace.pos);
+		start = pos;
 
-	/* write timestamp and event to trace buffer */
-	t =(volatile uint32_t*)(MAILBOX_TRACE_BASE + trace.pos);
-	t[0] = platform_timer_get(platform_timer);
-	t[1] = event;
+		/* block start and long gaps need the full timestamp */
+		sync = (start & TRACE_BLOCK_MASK) == 0 ||
+			ts - trace.last >= TRACE_SYNC_TICKS;
+		size = (argc + 1) * TRACE_WORD + (sync ? TRACE_SYNC_SIZE : 0);
 
-	/* writeback trace data */
-	dcache_writeback_region((void*)t, sizeof(uint32_t) * 2);
+		/* records don't cross blocks, rest of block is already 0 */
+		if ((start & TRACE_BLOCK_MASK) + size > TRACE_BLOCK_SIZE) {
+			start = trace_block_next(start);
+			sync = 1;
+			size = (argc + 1) * TRACE_WORD + TRACE_SYNC_SIZE;
+		}
 
-	trace.pos += (sizeof(uint32_t) << 1);
+		next = start + size;
+		if (next >= MAILBOX_TRACE_SIZE)
+			next = 0;
+	} while (atomic_cmpxchg(&trace.pos, pos, next) != pos);
 
-	if (trace.pos >= MAILBOX_TRACE_SIZE)
-		trace.pos = 0;
+	/* write record to trace buffer */
+	t = (volatile uint32_t *)(MAILBOX_TRACE_BASE + start);
+	if (sync) {
+		*t++ = TRACE_REC_HDR(TRACE_ID_SYNC, ts);
+		*t++ = ts;
+	}
+	*t++ = TRACE_REC_HDR(id >> 2, ts);
+	if (argc > 0)
+		*t++ = a0;
+	if (argc > 1)
+		*t++ = a1;
+	if (argc > 2)
+		*t = a2;
 
-	spin_unlock_irq(&trace.lock, flags);
+	trace.last = ts;
+
+	if ((start & TRACE_BLOCK_MASK) == 0) {
+		trace_block_clear(start);
+		trace_block_done(start);
+	}
+}
+
+/* writeback whole ring, records in the current block are then visible */
+void trace_flush(void)
+{
+	dcache_writeback_region((void *)MAILBOX_TRACE_BASE, MAILBOX_TRACE_SIZE);
+}
+
+void trace_set_mask(uint32_t level, uint32_t mask)
+{
+	if (level < TRACE_LEVELS)
+		trace_mask[level] = mask;
 }
 
 void trace_off(void)
@@ -77,7 +190,12 @@ void trace_off(void)
 
 void trace_init(struct reef *reef)
 {
+	atomic_init(&trace.pos, 0);
+	trace.last = 0;
+
+	/* no valid blocks until the first record */
+	bzero((void *)MAILBOX_TRACE_BASE, MAILBOX_TRACE_SIZE);
+	dcache_writeback_region((void *)MAILBOX_TRACE_BASE, MAILBOX_TRACE_SIZE);
+
 	trace.enable = 1;
-	trace.pos = 0;
-	spinlock_init(&trace.lock);
 }
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ *
+ * Stack and IRQ off watermarks.
+ *
+ * The unused part of the stack is painted with a pattern at boot and the
+ * deepest stack use is found by looking for the first overwritten word. All
+ * interrupt levels up to the global disable level run on this stack.
+ *
+ * Sections with IRQs globally disabled are timed from the outermost
+ * interrupt_global_disable() to the interrupt_global_enable() that unmasks
+ * again. The longest section is kept with the code address of its disable.
+ * Sections using arch_interrupt_global_disable() directly are not timed,
+ * these are the boot time timer register and the watermark reset itself.
+ */
+
+#include <stdint.h>
+#include <reef/reef.h>
+#include <reef/interrupt.h>
+#include <reef/timer.h>
+#include <reef/watermark.h>
+#include <arch/reef.h>
+
+#if WATERMARK
+
+/* stack paint pattern */
+#define STACK_PAINT	0xa5a5a5a5
+
+/* bytes below the current stack pointer left unpainted */
+#define STACK_PAINT_MARGIN	64
+
+/* bytes painted in each IRQ off section */
+#define STACK_PAINT_CHUNK	256
+
+/* stack limits from linker script */
+extern uint32_t __stack;
+extern uint32_t _stack_sentry;
+
+struct irq_off_watermark irq_off_wm;
+
+/* called from the disable site, return address is the site */
+void __attribute__((noinline)) _watermark_irq_off(void)
+{
+	irq_off_wm.active = 1;
+	irq_off_wm.start = timer_get_cycles();
+	irq_off_wm.start_site = (uint32_t)__builtin_return_address(0);
+}
+
+void _watermark_irq_on(void)
+{
+	uint32_t cycles = timer_get_cycles() - irq_off_wm.start;
+
+	irq_off_wm.active = 0;
+
+	if (cycles > irq_off_wm.max) {
+		irq_off_wm.max = cycles;
+		irq_off_wm.max_site = irq_off_wm.start_site;
+	}
+}
+
+/*
+ * Paint stack below the caller, IRQs off as they use the same stack. It's
+ * painted in short measured sections so a reset doesn't hold off IRQs for
+ * the whole stack.
+ */
+void stack_paint(void)
+{
+	uint32_t *word = &_stack_sentry;
+	uint32_t *end, *chunk;
+	uint32_t flags;
+
+	end = (uint32_t *)(arch_get_stack_ptr() - STACK_PAINT_MARGIN);
+
+	while (word < end) {
+		flags = interrupt_global_disable();
+
+		chunk = word + STACK_PAINT_CHUNK / sizeof(*word);
+		if (chunk > end)
+			chunk = end;
+		while (word < chunk)
+			*word++ = STACK_PAINT;
+
+		interrupt_global_enable(flags);
+	}
+}
+
+uint32_t stack_size(void)
+{
+	return (uint32_t)&__stack - (uint32_t)&_stack_sentry;
+}
+
+/* deepest stack use since the stack was painted */
+uint32_t stack_used(void)
+{
+	uint32_t *word = &_stack_sentry;
+
+	while (word < &__stack && *word == STACK_PAINT)
+		word++;
+
+	return (uint32_t)&__stack - (uint32_t)word;
+}
+
+void watermark_reset(void)
+{
+	uint32_t flags;
+
+	flags = arch_interrupt_global_disable();
+	irq_off_wm.max = 0;
+	irq_off_wm.max_site = 0;
+	arch_interrupt_global_enable(flags);
+
+	stack_paint();
+}
+
+#endif
@@ -38,6 +38,7 @@
 #include <reef/lock.h>
 #include <reef/notifier.h>
 #include <reef/debug.h>
+#include <reef/load.h>
 #include <platform/clk.h>
 #include <platform/platform.h>
 
@@ -273,8 +274,11 @@ static void queue_reschedule(struct work_queue *queue)
 static void queue_run(void *data)
 {
 	struct work_queue *queue = (struct work_queue *)data;
+	struct load_frame frame;
 	uint32_t flags;
 
+	load_frame_begin(&frame);
+
 	/* clear interrupt */
 	work_clear_timer(queue);
 
@@ -292,6 +296,8 @@ static void queue_run(void *data)
 	queue_reschedule(queue);
 
 	spin_unlock_irq(&queue->lock, flags);
+
+	load_frame_end(&frame, NULL);
 }
 
 /* notification of CPU frequency changes - atomic PRE and POST sequence */
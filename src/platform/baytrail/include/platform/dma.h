@@ -48,6 +48,7 @@
 #define DW_CTLH_CLASS(x)		(x << 29)
 #define DW_CTLH_WEIGHT(x)		(x << 18)
 /* CFG_LO */
+#define DW_CFG_CH_PRIOR(x)		(x << 5)
 #define DW_CFG_CH_DRAIN			0x400
 /* CFG_HI */
 #define DW_CFGH_SRC_PER(x)		(x << 0)
@@ -60,6 +61,13 @@
 #define DW_FIFO_PART1_HI		0x040C
 #define DW_CH_SAI_ERR			0x0410
 
+/* DMAC channel class for each DMA_PRIO_, higher class wins bus arbitration.
+ * Used for both the CTL_HI class and the CFG_LO channel priority.
+ */
+#define DW_CLASS_PRIO_LOW		0
+#define DW_CLASS_PRIO_NORMAL		6
+#define DW_CLASS_PRIO_HIGH		7
+
 /* default initial setup register values */
 #define DW_CFG_LOW_DEF	0x00000003
 #define DW_CFG_HIGH_DEF	0x0
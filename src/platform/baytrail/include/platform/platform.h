@@ -73,6 +73,9 @@ struct reef;
 /* DMA host transfer timeouts in microseconds */
 #define PLATFORM_HOST_DMA_TIMEOUT	50
 
+/* IPC task scheduling deadline in microseconds */
+#define PLATFORM_IPC_DEADLINE	5000
+
 /* WorkQ window size in microseconds */
 #define PLATFORM_WORKQ_WINDOW	2000
 
@@ -82,6 +85,13 @@ struct reef;
 /* the interval of DMA trace copying */
 #define DMA_TRACE_US		500000
 
+/* sampling profiler timer, CCOMPARE2 at interrupt level 3 */
+#define PLATFORM_PROFILE_TIMER	TIMER2
+#define PLATFORM_PROFILE_LEVEL	3
+
+/* delay before sending a full DMA trace half */
+#define DMA_TRACE_RESCHEDULE_US	500
+
 /* Platform defined panic code */
 #define platform_panic(__x) \
 		shim_write(SHIM_IPCXL, ((shim_read(SHIM_IPCXL) & 0xc0000000) |\
@@ -35,6 +35,7 @@
 #include <stdint.h>
 #include <reef/timer.h>
 #include <platform/interrupt.h>
+#include <platform/shim.h>
 
 #define TIMER_COUNT	4
 
@@ -57,6 +58,12 @@ uint64_t platform_timer_get(struct timer *timer);
 void platform_timer_start(struct timer *timer);
 void platform_timer_stop(struct timer *timer);
 
+/* low 32 bits of platform timer, a single register read for tracing */
+static inline uint32_t platform_timer_get_low(void)
+{
+	return shim_read(SHIM_EXT_TIMER_STAT);
+}
+
 /* get timestamp for host stream DMA position */
 void platform_host_timestamp(struct comp_dev *host,
 	struct sof_ipc_stream_posn *posn);
@@ -34,6 +34,7 @@
 #include <platform/shim.h>
 #include <platform/interrupt.h>
 #include <reef/debug.h>
+#include <reef/interrupt.h>
 #include <reef/audio/component.h>
 #include <stdint.h>
 
@@ -103,7 +104,7 @@ int platform_timer_set(struct timer *timer, uint64_t ticks)
 	if ((ticks & 0xffffffff) < 0x2)
 		ticks += 2;
 
-	flags = arch_interrupt_global_disable();
+	flags = interrupt_global_disable();
 
 	/* same hi 64 bit context as ticks ? */
 	if (hitimeout == timer->hitime) {
@@ -113,7 +114,7 @@ int platform_timer_set(struct timer *timer, uint64_t ticks)
 		timer->hitimeout = 0;
 	} else if (hitimeout < timer->hitime) {
 		/* cant be in the past */
-		arch_interrupt_global_enable(flags);
+		interrupt_global_enable(flags);
 		return -EINVAL;
 	} else {
 		/* set for checking at next timeout */
@@ -125,7 +126,7 @@ int platform_timer_set(struct timer *timer, uint64_t ticks)
 	shim_write(SHIM_EXT_TIMER_CNTLH, SHIM_EXT_TIMER_RUN);
 	shim_write(SHIM_EXT_TIMER_CNTLL, time);
 
-	arch_interrupt_global_enable(flags);
+	interrupt_global_enable(flags);
 
 	return 0;
 }
@@ -141,7 +142,7 @@ uint64_t platform_timer_get(struct timer *timer)
 	uint64_t time;
 	uint32_t flags, low, high;
 
-	flags = arch_interrupt_global_disable();
+	flags = interrupt_global_disable();
 
 	/* read low 32 bits */
 	low = shim_read(SHIM_EXT_TIMER_STAT);
@@ -158,7 +159,7 @@ uint64_t platform_timer_get(struct timer *timer)
 
 	time = ((uint64_t)high << 32) | low;
 
-	arch_interrupt_global_enable(flags);
+	interrupt_global_enable(flags);
 
 	return time;
 }
@@ -205,14 +206,14 @@ static int platform_timer_register(struct timer *timer,
 	uint32_t flags;
 	int ret;
 
-	flags = arch_interrupt_global_disable();
+	flags = interrupt_global_disable();
 	tdata->handler2 = handler;
 	tdata->arg2 = arg;
 	timer->timer_data = tdata;
 	timer->hitime = 0;
 	timer->hitimeout = 0;
 	ret = arch_interrupt_register(timer->id, platform_timer_64_handler, timer);
-	arch_interrupt_global_enable(flags);
+	interrupt_global_enable(flags);
 
 	return ret;
 }
@@ -42,6 +42,7 @@
 #include <reef/work.h>
 #include <reef/debug.h>
 #include <reef/trace.h>
+#include <reef/load.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -68,6 +69,9 @@ int do_task(struct reef *reef)
         sys_comp_eq_iir_init();
         sys_comp_eq_fir_init();
 
+	/* DSP load windows */
+	load_init();
+
 #if STATIC_PIPE
 	/* init static pipeline */
 	pdata.p = init_static_pipeline();
@@ -80,10 +84,15 @@ int do_task(struct reef *reef)
 	/* main audio IPC processing loop */
 	while (1) {
 
+		/* make partial trace cache lines visible before sleeping */
+		trace_flush();
+
 		/* sleep until next IPC or DMA */
+		load_idle_begin();
 		wait_for_interrupt(0);
+		load_idle_end();
 
-		/* now process any IPC messages from host */
+		/* make sure IPC task runs for any messages it missed */
 		ipc_process_msg_queue();
 	}
 
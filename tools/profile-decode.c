@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ * Host decoder for the sampling profiler records in the DMA trace, see
+ * uapi/trace.h.
+ *
+ * Records are found by their magic in a raw copy of the DMA trace and the
+ * sampled PCs are mapped to functions using the symbol table dumped at build
+ * time to reef-<platform>.sym by objdump -t. Build with :-
+ *
+ *	cc -o profile-decode profile-decode.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../src/include/uapi/trace.h"
+
+/* max entries in a record, firmware sends fewer */
+#define PROFILE_MAX_RECORD	256
+
+#define PROFILE_MAX_CTX		64
+#define PROFILE_TOP_DEFAULT	20
+
+struct symbol {
+	uint32_t addr;
+	uint32_t size;
+	char *name;
+	uint64_t count;			/* all contexts */
+	uint64_t ctx_count[PROFILE_MAX_CTX];
+};
+
+struct profile {
+	struct symbol *sym;
+	int num_syms;
+	struct symbol unknown;
+	uint32_t ctx[PROFILE_MAX_CTX];
+	uint64_t ctx_total[PROFILE_MAX_CTX];
+	int num_ctx;
+	uint64_t samples;
+	uint64_t dropped;
+	uint64_t counted;
+	uint32_t records;
+	uint32_t reports;
+};
+
+static void usage(char *name)
+{
+	fprintf(stdout, "%s:\t -s symbols -t trace [-n top] [-c]\n", name);
+	exit(0);
+}
+
+static int sym_cmp(const void *a, const void *b)
+{
+	const struct symbol *sa = a, *sb = b;
+
+	if (sa->addr == sb->addr)
+		return 0;
+	return sa->addr < sb->addr ? -1 : 1;
+}
+
+/* function symbols from objdump -t, tokens are
+ * address flags... F section size [.hidden] name */
+static int load_symbols(struct profile *p, const char *name)
+{
+	char line[512];
+	char *tok[16];
+	FILE *f;
+	int count, i, fn;
+	int alloc = 0;
+
+	f = fopen(name, "r");
+	if (f == NULL) {
+		fprintf(stderr, "error: can't open %s %d\n", name, -errno);
+		return -errno;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+
+		count = 0;
+		tok[count] = strtok(line, " \t\n");
+		while (tok[count] && count < 15)
+			tok[++count] = strtok(NULL, " \t\n");
+
+		/* find function flag */
+		for (fn = 1; fn < count; fn++) {
+			if (strcmp(tok[fn], "F") == 0)
+				break;
+		}
+		if (fn + 3 >= count)
+			continue;
+
+		if (p->num_syms == alloc) {
+			alloc = alloc ? alloc * 2 : 256;
+			p->sym = realloc(p->sym, alloc * sizeof(*p->sym));
+			if (p->sym == NULL) {
+				fclose(f);
+				return -ENOMEM;
+			}
+		}
+
+		memset(&p->sym[p->num_syms], 0, sizeof(*p->sym));
+		p->sym[p->num_syms].addr = strtoul(tok[0], NULL, 16);
+		p->sym[p->num_syms].size = strtoul(tok[fn + 2], NULL, 16);
+		p->sym[p->num_syms].name = strdup(tok[count - 1]);
+		p->num_syms++;
+	}
+
+	fclose(f);
+
+	qsort(p->sym, p->num_syms, sizeof(*p->sym), sym_cmp);
+
+	/* assembler symbols can have no size, use the next symbol */
+	for (i = 0; i < p->num_syms - 1; i++) {
+		if (p->sym[i].size == 0)
+			p->sym[i].size = p->sym[i + 1].addr - p->sym[i].addr;
+	}
+
+	p->unknown.name = "[unknown]";
+	return 0;
+}
+
+static struct symbol *find_symbol(struct profile *p, uint32_t pc)
+{
+	int lo = 0, hi = p->num_syms - 1, mid;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if (pc < p->sym[mid].addr)
+			hi = mid - 1;
+		else if (pc >= p->sym[mid].addr + p->sym[mid].size)
+			lo = mid + 1;
+		else
+			return &p->sym[mid];
+	}
+
+	return &p->unknown;
+}
+
+static int find_ctx(struct profile *p, uint32_t ctx)
+{
+	int i;
+
+	for (i = 0; i < p->num_ctx; i++) {
+		if (p->ctx[i] == ctx)
+			return i;
+	}
+
+	/* share the last slot when full */
+	if (p->num_ctx == PROFILE_MAX_CTX)
+		return PROFILE_MAX_CTX - 1;
+
+	p->ctx[p->num_ctx] = ctx;
+	return p->num_ctx++;
+}
+
+static void add_record(struct profile *p, struct trace_profile_hdr *hdr,
+	struct trace_profile_entry *entry)
+{
+	struct symbol *sym;
+	uint32_t i;
+	int c;
+
+	for (i = 0; i < hdr->count; i++) {
+		sym = find_symbol(p, entry[i].pc);
+		c = find_ctx(p, entry[i].ctx);
+
+		sym->count += entry[i].count;
+		sym->ctx_count[c] += entry[i].count;
+		p->ctx_total[c] += entry[i].count;
+		p->counted += entry[i].count;
+	}
+
+	p->records++;
+
+	/* last record of a report has the totals */
+	if (hdr->samples) {
+		p->samples += hdr->samples;
+		p->dropped += hdr->dropped;
+		p->reports++;
+	}
+}
+
+/* records are mixed with text trace so look for them at any offset */
+static void scan_trace(struct profile *p, uint8_t *buf, size_t size)
+{
+	struct trace_profile_hdr hdr;
+	struct trace_profile_entry entry[PROFILE_MAX_RECORD];
+	size_t offset = 0, len;
+
+	while (offset + sizeof(hdr) <= size) {
+
+		memcpy(&hdr, buf + offset, sizeof(hdr));
+		if (hdr.magic != TRACE_PROFILE_MAGIC ||
+			hdr.count > PROFILE_MAX_RECORD) {
+			offset++;
+			continue;
+		}
+
+		len = sizeof(hdr) + hdr.count * sizeof(*entry);
+		if (offset + len > size) {
+			fprintf(stderr, "warning: truncated record at 0x%zx\n",
+				offset);
+			break;
+		}
+
+		memcpy(entry, buf + offset + sizeof(hdr),
+			hdr.count * sizeof(*entry));
+
+		add_record(p, &hdr, entry);
+		offset += len;
+	}
+}
+
+static int count_cmp(const void *a, const void *b)
+{
+	const struct symbol *sa = *(struct symbol **)a;
+	const struct symbol *sb = *(struct symbol **)b;
+
+	if (sa->count == sb->count)
+		return 0;
+	return sa->count > sb->count ? -1 : 1;
+}
+
+static void print_ctx(uint32_t ctx)
+{
+	if (ctx == TRACE_PROFILE_CTX_NONE)
+		fprintf(stdout, "other");
+	else
+		fprintf(stdout, "pipe %u comp %u", ctx >> 16, ctx & 0xffff);
+}
+
+static void print_profile(struct profile *p, int top, int show_ctx)
+{
+	struct symbol **order;
+	struct symbol *sym;
+	uint64_t total = p->counted;
+	int num = p->num_syms + 1;
+	int i, c;
+
+	fprintf(stdout, "reports %u records %u samples %llu dropped %llu\n",
+		p->reports, p->records, (unsigned long long)p->samples,
+		(unsigned long long)p->dropped);
+
+	if (total == 0)
+		return;
+
+	order = calloc(num, sizeof(*order));
+	if (order == NULL)
+		return;
+
+	for (i = 0; i < p->num_syms; i++)
+		order[i] = &p->sym[i];
+	order[p->num_syms] = &p->unknown;
+	qsort(order, num, sizeof(*order), count_cmp);
+
+	fprintf(stdout, "\n%10s %7s  %s\n", "samples", "%", "function");
+	for (i = 0; i < num && i < top; i++) {
+		sym = order[i];
+		if (sym->count == 0)
+			break;
+
+		fprintf(stdout, "%10llu %6.2f%%  %s\n",
+			(unsigned long long)sym->count,
+			100.0 * sym->count / total, sym->name);
+
+		if (!show_ctx)
+			continue;
+
+		for (c = 0; c < p->num_ctx; c++) {
+			if (sym->ctx_count[c] == 0)
+				continue;
+			fprintf(stdout, "%10llu %6.2f%%    ",
+				(unsigned long long)sym->ctx_count[c],
+				100.0 * sym->ctx_count[c] / total);
+			print_ctx(p->ctx[c]);
+			fprintf(stdout, "\n");
+		}
+	}
+
+	fprintf(stdout, "\n%10s %7s  %s\n", "samples", "%", "context");
+	for (c = 0; c < p->num_ctx; c++) {
+		fprintf(stdout, "%10llu %6.2f%%  ",
+			(unsigned long long)p->ctx_total[c],
+			100.0 * p->ctx_total[c] / total);
+		print_ctx(p->ctx[c]);
+		fprintf(stdout, "\n");
+	}
+
+	free(order);
+}
+
+static void *read_file(const char *name, size_t *size)
+{
+	FILE *f;
+	void *buf;
+	long len;
+
+	f = fopen(name, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "error: can't open %s %d\n", name, -errno);
+		return NULL;
+	}
+
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	buf = calloc(1, len + 1);
+	if (buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "error: can't read %s\n", name);
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+
+	fclose(f);
+	*size = len;
+	return buf;
+}
+
+int main(int argc, char *argv[])
+{
+	struct profile p;
+	char *sym_name = NULL, *trace_name = NULL;
+	uint8_t *trace;
+	size_t trace_size;
+	int top = PROFILE_TOP_DEFAULT, show_ctx = 0;
+	int opt;
+
+	memset(&p, 0, sizeof(p));
+
+	while ((opt = getopt(argc, argv, "s:t:n:ch")) != -1) {
+		switch (opt) {
+		case 's':
+			sym_name = optarg;
+			break;
+		case 't':
+			trace_name = optarg;
+			break;
+		case 'n':
+			top = atoi(optarg);
+			break;
+		case 'c':
+			show_ctx = 1;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (sym_name == NULL || trace_name == NULL)
+		usage(argv[0]);
+
+	if (load_symbols(&p, sym_name) < 0)
+		return -EINVAL;
+
+	trace = read_file(trace_name, &trace_size);
+	if (trace == NULL)
+		return -EINVAL;
+
+	scan_trace(&p, trace, trace_size);
+	print_profile(&p, top, show_ctx);
+
+	free(trace);
+	return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Intel Corporation nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Author: Liam Girdwood <liam.r.girdwood@linux.intel.com>
+ *
+ * Host decoder for the compact mailbox trace, see uapi/trace.h.
+ *
+ * The dictionary is the .trace_dict section of the firmware ELF, dumped at
+ * build time to reef-<platform>.dict. The trace is a raw copy of the mailbox
+ * trace region. With -l the latency markers are shown as per period
+ * timelines instead of a record listing. Build with :-
+ *
+ *	cc -o trace-decode trace-decode.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "../src/include/uapi/trace.h"
+
+#define TRACE_BLOCK_WORDS	(TRACE_BLOCK_SIZE / sizeof(uint32_t))
+
+/* default DSP timer clock on BYT and CHT */
+#define TRACE_CLOCK_HZ		19200000
+
+/* trace class names, indexed by TRACE_CLASS_ >> 24 */
+static const char *class_name[] = {
+	"value", "irq", "ipc", "pipe", "host", "dai", "dma", "ssp", "comp",
+	"wait", "lock", "mem", "mixer", "buffer", "volume", "switch", "mux",
+	"src", "tone", "eq-fir", "eq-iir", "mark", "profile", "perf",
+};
+
+/* latency markers, see reef/trace.h */
+#define TRACE_CLASS_MARK	(21 << 24)
+#define TRACE_MARK_TASK_IPC	0xffff
+
+#define TL_MAX_PIPES		16
+#define TL_MAX_COPIES		16
+
+/* component copy time in one period */
+struct tl_copy {
+	uint32_t comp_id;
+	uint32_t begin;
+	uint32_t ticks;
+};
+
+/* one scheduling period of a pipeline */
+struct tl_period {
+	uint32_t pipe_id;
+	int used;
+	int active;		/* period has started */
+	int running;		/* task has started */
+	uint32_t irq;		/* first DMA completion or task release */
+	uint32_t start;		/* task start */
+	uint32_t end;		/* last comp_copy() end */
+	uint32_t deadline;
+	uint32_t count;
+	struct tl_copy copy[TL_MAX_COPIES];
+};
+
+struct timeline {
+	struct tl_period pipe[TL_MAX_PIPES];
+	uint32_t ipc_rx;
+	int ipc_pending;
+};
+
+struct block {
+	uint32_t *data;
+	uint32_t ts;		/* sync timestamp */
+};
+
+struct decoder {
+	uint8_t *dict;
+	size_t dict_size;
+	uint32_t clock_hz;
+	uint32_t first;		/* timestamp of first record */
+	int have_first;
+	struct timeline *tl;	/* timeline mode */
+};
+
+static void usage(char *name)
+{
+	fprintf(stdout, "%s:\t -d dictionary -t trace [-c clock_hz] [-l]\n",
+		name);
+	exit(0);
+}
+
+static void *read_file(const char *name, size_t *size)
+{
+	FILE *f;
+	void *buf;
+	long len;
+
+	f = fopen(name, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "error: can't open %s %d\n", name, -errno);
+		return NULL;
+	}
+
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	buf = calloc(1, len + sizeof(uint32_t));
+	if (buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "error: can't read %s\n", name);
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+
+	fclose(f);
+	*size = len;
+	return buf;
+}
+
+/* blocks in time order, timestamps are compared modulo 2^32 */
+static int block_cmp(const void *a, const void *b)
+{
+	const struct block *ba = a, *bb = b;
+
+	return (int32_t)(ba->ts - bb->ts);
+}
+
+static struct trace_dict_entry *dict_entry(struct decoder *dec, uint32_t id)
+{
+	uint32_t offset = id * sizeof(uint32_t);
+
+	if (offset + sizeof(struct trace_dict_entry) > dec->dict_size)
+		return NULL;
+
+	return (struct trace_dict_entry *)(dec->dict + offset);
+}
+
+static void print_record(struct decoder *dec, uint32_t ts,
+	struct trace_dict_entry *e, uint32_t *args)
+{
+	uint32_t class = e->trace_class >> 24;
+	uint32_t i;
+
+	if (!dec->have_first) {
+		dec->first = ts;
+		dec->have_first = 1;
+	}
+
+	fprintf(stdout, "%12.3f us  %-8s", (double)(ts - dec->first) *
+		1000000.0 / dec->clock_hz,
+		class < sizeof(class_name) / sizeof(class_name[0]) ?
+		class_name[class] : "unknown");
+
+	if (e->trace_class)
+		fprintf(stdout, " %.3s", e->code);
+
+	for (i = 0; i < e->argc; i++)
+		fprintf(stdout, " 0x%8.8x", args[i]);
+
+	fprintf(stdout, "\t%.*s:%u\n", (int)(dec->dict_size -
+		((uint8_t *)e->file - dec->dict)), e->file, e->line);
+}
+
+static double tl_us(struct decoder *dec, int32_t ticks)
+{
+	return (double)ticks * 1000000.0 / dec->clock_hz;
+}
+
+static struct tl_period *tl_get(struct timeline *tl, uint32_t pipe_id)
+{
+	int i;
+
+	for (i = 0; i < TL_MAX_PIPES; i++) {
+		if (tl->pipe[i].used && tl->pipe[i].pipe_id == pipe_id)
+			return &tl->pipe[i];
+	}
+
+	for (i = 0; i < TL_MAX_PIPES; i++) {
+		if (!tl->pipe[i].used) {
+			tl->pipe[i].used = 1;
+			tl->pipe[i].pipe_id = pipe_id;
+			return &tl->pipe[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* print a complete period - IRQ to task latency, copies and slack */
+static void tl_period_end(struct decoder *dec, struct tl_period *p)
+{
+	uint32_t end = p->count ? p->end : p->start;
+	uint32_t i;
+
+	if (p->active && p->running) {
+		fprintf(stdout, "%12.3f us  pipe %u irq->run %.3f us",
+			tl_us(dec, p->irq - dec->first), p->pipe_id,
+			tl_us(dec, p->start - p->irq));
+
+		for (i = 0; i < p->count; i++)
+			fprintf(stdout, " comp %u %.3f us", p->copy[i].comp_id,
+				tl_us(dec, p->copy[i].ticks));
+
+		fprintf(stdout, " slack %.3f us\n",
+			tl_us(dec, (int32_t)(p->deadline - end)));
+	}
+
+	p->active = 0;
+	p->running = 0;
+	p->count = 0;
+}
+
+static void tl_period_start(struct tl_period *p, uint32_t ts)
+{
+	if (!p->active) {
+		p->active = 1;
+		p->irq = ts;
+	}
+}
+
+static struct tl_copy *tl_copy_get(struct tl_period *p, uint32_t comp_id)
+{
+	uint32_t i;
+
+	for (i = 0; i < p->count; i++) {
+		if (p->copy[i].comp_id == comp_id)
+			return &p->copy[i];
+	}
+
+	if (p->count == TL_MAX_COPIES)
+		return NULL;
+
+	p->copy[p->count].comp_id = comp_id;
+	p->copy[p->count].ticks = 0;
+	return &p->copy[p->count++];
+}
+
+static void tl_record(struct decoder *dec, uint32_t ts,
+	struct trace_dict_entry *e, uint32_t *args)
+{
+	struct timeline *tl = dec->tl;
+	struct tl_period *p;
+	struct tl_copy *c;
+
+	if (!dec->have_first) {
+		dec->first = ts;
+		dec->have_first = 1;
+	}
+
+	if (e->trace_class != TRACE_CLASS_MARK || e->argc == 0)
+		return;
+
+	/* IPC command latency */
+	if (!strncmp(e->code, "mIr", 3)) {
+		tl->ipc_rx = ts;
+		tl->ipc_pending = 1;
+		return;
+	}
+	if (!strncmp(e->code, "mIp", 3)) {
+		if (tl->ipc_pending)
+			fprintf(stdout, "%12.3f us  ipc rx->done %.3f us "
+				"error %d\n", tl_us(dec, tl->ipc_rx - dec->first),
+				tl_us(dec, ts - tl->ipc_rx), (int32_t)args[0]);
+		return;
+	}
+
+	/* task markers carry the task ID, the rest the pipeline ID */
+	if (e->code[1] == 'T') {
+		if (args[0] == TRACE_MARK_TASK_IPC)
+			return;
+		p = tl_get(tl, args[0]);
+	} else
+		p = tl_get(tl, args[0] >> 16);
+	if (p == NULL)
+		return;
+
+	switch (e->code[1] << 8 | e->code[2]) {
+	case 'D' << 8 | 'd':
+	case 'D' << 8 | 'h':
+		/* DMA completion after the task ran starts the next period */
+		if (p->running)
+			tl_period_end(dec, p);
+		tl_period_start(p, ts);
+		break;
+	case 'T' << 8 | 'q':
+		if (p->running)
+			tl_period_end(dec, p);
+		tl_period_start(p, ts);
+		p->deadline = args[1];
+		break;
+	case 'T' << 8 | 's':
+		tl_period_start(p, ts);
+		p->start = ts;
+		p->deadline = args[1];
+		p->running = 1;
+		break;
+	case 'C' << 8 | 'b':
+		c = tl_copy_get(p, args[0] & 0xffff);
+		if (c)
+			c->begin = ts;
+		break;
+	case 'C' << 8 | 'e':
+		c = tl_copy_get(p, args[0] & 0xffff);
+		if (c)
+			c->ticks += ts - c->begin;
+		p->end = ts;
+		break;
+	default:
+		break;
+	}
+}
+
+/* decode records in one block until the end marker */
+static void decode_block(struct decoder *dec, struct block *b)
+{
+	struct trace_dict_entry *e;
+	uint32_t *w = b->data;
+	uint32_t i = 0, id, ts = 0, ts16;
+
+	while (i < TRACE_BLOCK_WORDS) {
+		id = TRACE_REC_ID(w[i]);
+		ts16 = TRACE_REC_TS(w[i]);
+
+		if (id == TRACE_ID_END)
+			return;
+
+		if (id == TRACE_ID_SYNC) {
+			if (i + 1 >= TRACE_BLOCK_WORDS)
+				return;
+			ts = w[i + 1];
+			i += 2;
+			continue;
+		}
+
+		/* unwrap timestamp, the firmware syncs before it is ambiguous */
+		ts += (ts16 - ts) & 0xffff;
+
+		e = dict_entry(dec, id);
+		if (e == NULL || e->argc > TRACE_MAX_ARGS ||
+			i + 1 + e->argc > TRACE_BLOCK_WORDS) {
+			fprintf(stderr, "error: bad record 0x%8.8x\n", w[i]);
+			return;
+		}
+
+		if (dec->tl)
+			tl_record(dec, ts, e, &w[i + 1]);
+		else
+			print_record(dec, ts, e, &w[i + 1]);
+		i += 1 + e->argc;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	struct decoder dec;
+	struct block *blocks;
+	uint8_t *trace;
+	size_t trace_size;
+	char *dict_name = NULL, *trace_name = NULL;
+	size_t offset;
+	uint32_t *w;
+	int opt, i, count = 0;
+
+	memset(&dec, 0, sizeof(dec));
+	dec.clock_hz = TRACE_CLOCK_HZ;
+
+	while ((opt = getopt(argc, argv, "d:t:c:lh")) != -1) {
+		switch (opt) {
+		case 'd':
+			dict_name = optarg;
+			break;
+		case 't':
+			trace_name = optarg;
+			break;
+		case 'c':
+			dec.clock_hz = atoi(optarg);
+			break;
+		case 'l':
+			dec.tl = calloc(1, sizeof(*dec.tl));
+			if (dec.tl == NULL)
+				return -ENOMEM;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (dict_name == NULL || trace_name == NULL || dec.clock_hz == 0)
+		usage(argv[0]);
+
+	dec.dict = read_file(dict_name, &dec.dict_size);
+	if (dec.dict == NULL)
+		return -EINVAL;
+
+	trace = read_file(trace_name, &trace_size);
+	if (trace == NULL)
+		return -EINVAL;
+
+	blocks = calloc(trace_size / TRACE_BLOCK_SIZE + 1, sizeof(*blocks));
+	if (blocks == NULL)
+		return -ENOMEM;
+
+	/* valid blocks start with a sync record */
+	for (offset = 0; offset + TRACE_BLOCK_SIZE <= trace_size;
+		offset += TRACE_BLOCK_SIZE) {
+		w = (uint32_t *)(trace + offset);
+		if (TRACE_REC_ID(w[0]) != TRACE_ID_SYNC)
+			continue;
+		blocks[count].data = w;
+		blocks[count].ts = w[1];
+		count++;
+	}
+
+	qsort(blocks, count, sizeof(*blocks), block_cmp);
+
+	for (i = 0; i < count; i++)
+		decode_block(&dec, &blocks[i]);
+
+	/* periods still open at the end of the trace */
+	if (dec.tl) {
+		for (i = 0; i < TL_MAX_PIPES; i++)
+			tl_period_end(&dec, &dec.tl->pipe[i]);
+		free(dec.tl);
+	}
+
+	free(blocks);
+	free(trace);
+	free(dec.dict);
+	return 0;
+}